@@ -2,6 +2,8 @@
 git add ./src/plugin_description
 git add ./src/simple_plugin_example/
 git add ./src/visage_link
+git add ./src/visage_stub
+git add ./src/plugin_benchmark
 
 git add ./src/visage_link/data_access 
 git add ./src/visage_link/initializers
@@ -0,0 +1,173 @@
+// Property model test: the incremental update of the initial mechanical properties (only the new layers
+// are read and mixed every step, GridTransfer kernels) against the full recompute of the whole column
+// (StructuredGrid::nodal_to_elemental over the whole grid), on a model that grows over several display steps.
+// Every array the two paths write must be the same.
+// Built only when VISAGE_INCLUDE_DIRS points at the geometry libraries visage_link is built with.
+//
+//     gpm_mech_props_test [--cols 12] [--rows 9] [--sediments 3] [--steps 6]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <algorithm>
+
+#include "gpm_plugin_description.h"
+#include "DefaultConfiguration.h"
+#include "MechProperyModel.h"
+
+using namespace std;
+
+namespace {
+
+    //the nodal attributes of a growing synthetic model, as GPM hands them over: one array per surface
+    class layered_model
+    {
+    public:
+
+        layered_model( size_t ncols, size_t nrows, size_t nsediments ) : _ncols( ncols ), _nrows( nrows ), _nsediments( nsediments ) {}
+
+        void deposit( size_t nsurfaces )
+        {
+            vector<vector<float>>& top = _values["TOP"];
+            while(top.size( ) < nsurfaces)
+            {
+                size_t k = top.size( );
+                vector<float> z( _ncols * _nrows, -2000.0f );
+                if(k > 0) z = top.back( );
+                for(size_t n = 0; n < z.size( ); n++) z[n] += k == 0 ? 0.0f : 10.0f + 4.0f * sinf( 0.3f * n + k );
+                top.push_back( z );
+
+                for(size_t s = 0; s < _nsediments; s++)
+                {
+                    vector<float> fraction( _ncols * _nrows );
+                    for(size_t n = 0; n < fraction.size( ); n++)
+                        fraction[n] = (1.0f + sinf( 0.1f * n + 1.3f * s + 0.7f * k )) / (float)_nsediments;
+                    _values["SED" + to_string( s + 1 )].push_back( fraction );
+                }
+            }
+        }
+
+        //views of the current surfaces. Valid until the next deposit
+        attr_lookup_type attributes( )
+        {
+            const gpm_plugin_api_2d_memory_layout layout = { _nrows, _ncols, (ptrdiff_t)_ncols, 1 };
+            attr_lookup_type atts;
+            for(auto& [name, surfaces] : _values)
+                for(auto& surface : surfaces) atts[name].emplace_back( surface.data( ), layout );
+            return atts;
+        }
+
+        map<string, SedimentDescription> sediments( ) const
+        {
+            map<string, SedimentDescription> seds;
+            for(size_t s = 0; s < _nsediments; s++)
+            {
+                SedimentDescription& sed = seds["SED" + to_string( s + 1 )];
+                sed.id = "test_sed" + to_string( s + 1 );
+                sed.index = (int)s;
+                sed.properties = { { "YOUNGMOD", 1.0f + 0.5f * s }, { "POISSONR", 0.25f }, { "DENSITY", 2.2f + 0.1f * s },
+                                   { "POROSITY", 0.45f - 0.05f * s }, { "COHESION", 1.0f }, { "TENSILE_STRENGTH", 0.5f } };
+            }
+            return seds;
+        }
+
+    private:
+
+        size_t _ncols, _nrows, _nsediments;
+        map<string, vector<vector<float>>> _values;
+    };
+
+    //one property model with its own options and arrays, as the coupler holds them
+    struct model_under_test
+    {
+        model_under_test( size_t ncols, size_t nrows, bool incremental )
+        {
+            DefaultConfiguration config;
+            config.initialize_vs_options( options );
+
+            float lx = 100.0f * (ncols - 1), ly = 100.0f * (nrows - 1);
+            gpm_plugin_api_model_definition definition = { nrows, ncols, { 0.0f, lx, lx, 0.0f }, { 0.0f, 0.0f, ly, ly } };
+            config.initialize_model_extents( options, &definition );
+
+            model.incremental_update( ) = incremental;
+        }
+
+        void step( const attr_lookup_type& atts, const map<string, SedimentDescription>& sediments, int new_nsurf )
+        {
+            int old_nsurf = options->geometry( )->nsurfaces( );
+            options->geometry( )->set_num_surfaces( new_nsurf );
+            model.update_initial_mech_props( atts, sediments, options, data, old_nsurf, new_nsurf );
+        }
+
+        MechPropertiesDVT model;
+        VisageDeckSimulationOptions options;
+        ArrayData data;
+    };
+}
+
+int main( int argc, char* argv[] )
+{
+    size_t ncols = 12, nrows = 9, nsediments = 3, nsteps = 6;
+    for(int n = 1; n < argc; n++)
+    {
+        string arg = argv[n];
+        size_t value = n + 1 < argc ? stoul( argv[++n] ) : 0;
+        if(arg == "--cols") ncols = value;
+        else if(arg == "--rows") nrows = value;
+        else if(arg == "--sediments") nsediments = value;
+        else if(arg == "--steps") nsteps = value;
+        else
+        {
+            cerr << "usage: gpm_mech_props_test [--cols n] [--rows n] [--sediments n] [--steps n]" << endl;
+            return 2;
+        }
+    }
+
+    layered_model gpm( ncols, nrows, nsediments );
+    map<string, SedimentDescription> sediments = gpm.sediments( );
+    model_under_test incremental( ncols, nrows, true ), full( ncols, nrows, false );
+
+    int failed = 0;
+    for(size_t step = 0; step < nsteps; step++)
+    {
+        //one or two new surfaces per step
+        int nsurfaces = 2 + (int)(step + step / 2);
+        gpm.deposit( nsurfaces );
+        attr_lookup_type atts = gpm.attributes( );
+        incremental.step( atts, sediments, nsurfaces );
+        full.step( atts, sediments, nsurfaces );
+
+        for(const string& name : full.data.array_names( ))
+        {
+            const vector<float>& expected = full.data.get_array( name );
+            if(!incremental.data.contains( name ))
+            {
+                cout << "[gpm_mech_props_test] step " << step << ": " << name << " missing in the incremental update" << endl;
+                failed += 1;
+                continue;
+            }
+            const vector<float>& values = incremental.data.get_array( name );
+            if(values.size( ) != expected.size( ))
+            {
+                cout << "[gpm_mech_props_test] step " << step << ": " << name << " has " << values.size( ) << " values, expected " << expected.size( ) << endl;
+                failed += 1;
+                continue;
+            }
+
+            float max_difference = 0.0f;
+            for(size_t n = 0; n < values.size( ); n++)
+                max_difference = std::max( max_difference, fabsf( values[n] - expected[n] ) / std::max( 1.0f, fabsf( expected[n] ) ) );
+            if(max_difference > 1.0e-5f)
+            {
+                cout << "[gpm_mech_props_test] step " << step << ": " << name << " differs by " << max_difference << endl;
+                failed += 1;
+            }
+        }
+        cout << "[gpm_mech_props_test] step " << step << ": " << nsurfaces << " surfaces, " << full.data.count( ) << " arrays compared" << endl;
+    }
+
+    cout << "[gpm_mech_props_test] " << (failed == 0 ? "passed" : "FAILED") << endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+// Coupled-step benchmark: loads a GPM plugin library through the gpm_plugin_api_* entry points,
+// feeds it a synthetic model and reports per-phase wall time, throughput and peak memory as json.
+//
+//     gpm_plugin_benchmark --plugin <library> [--cols 100] [--rows 100] [--surfaces 50] [--sediments 4] [--steps 10]
+//                          [--solver "visage_emulator {snapshot} {xfile}"] [--worker <command>] [--async]
+//                          [--elastic] [--dir <work directory>] [--json <output file>]
+//
+// The model grows from one to --surfaces surfaces over --steps display steps, the way GPM deposits layers.
+// The solver is whatever the plugin is told to run: the emulator (--solver) or the shared memory worker (--worker),
+// so the numbers are the coupler's own cost plus a cheap, deterministic solve.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+
+#ifdef WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "gpm_plugin_driver.h"
+
+using namespace std;
+
+namespace {
+
+    struct benchmark_options : driver_options
+    {
+        string json;
+    };
+
+    bool parse_options( int argc, char* argv[], benchmark_options& options )
+    {
+        for(int n = 1; n < argc; n++)
+        {
+            string arg = argv[n];
+            auto next = [&]( ) -> string { return n + 1 < argc ? argv[++n] : ""; };
+
+            if(arg == "--plugin") options.plugin = next( );
+            else if(arg == "--cols") options.ncols = stoul( next( ) );
+            else if(arg == "--rows") options.nrows = stoul( next( ) );
+            else if(arg == "--surfaces") options.nsurfaces = stoul( next( ) );
+            else if(arg == "--sediments") options.nsediments = stoul( next( ) );
+            else if(arg == "--steps") options.nsteps = stoul( next( ) );
+            else if(arg == "--solver") options.solver = next( );
+            else if(arg == "--worker") options.worker = next( );
+            else if(arg == "--async") options.async_solver = true;
+            else if(arg == "--elastic") options.elastic = true;
+            else if(arg == "--dir") options.dir = next( );
+            else if(arg == "--json") options.json = next( );
+            else
+            {
+                cerr << "unknown option " << arg << endl;
+                return false;
+            }
+        }
+
+        return !options.plugin.empty( ) && options.ncols > 1 && options.nrows > 1 && options.nsurfaces > 1 && options.nsediments > 0 && options.nsteps > 0;
+    }
+
+    //peak resident set of this process and of the (waited for) solver processes, in MB
+    pair<double, double> peak_memory_mb( )
+    {
+#ifdef WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        GetProcessMemoryInfo( GetCurrentProcess( ), &counters, sizeof( counters ) );
+        return { counters.PeakWorkingSetSize / (1024.0 * 1024.0), 0.0 };
+#else
+        rusage self, children;
+        getrusage( RUSAGE_SELF, &self );
+        getrusage( RUSAGE_CHILDREN, &children );
+#ifdef __APPLE__
+        return { self.ru_maxrss / (1024.0 * 1024.0), children.ru_maxrss / (1024.0 * 1024.0) };
+#else
+        return { self.ru_maxrss / 1024.0, children.ru_maxrss / 1024.0 };
+#endif
+#endif
+    }
+
+    class phase_timer
+    {
+    public:
+
+        double time( function<void( )> f )
+        {
+            auto start = chrono::steady_clock::now( );
+            f( );
+            return chrono::duration<double>( chrono::steady_clock::now( ) - start ).count( );
+        }
+    };
+
+    struct step_timing
+    {
+        size_t nsurfaces = 0;
+        double process = 0.0;
+        double update = 0.0;
+        int process_code = 0;
+        int update_code = 0;
+    };
+}
+
+int main( int argc, char* argv[] )
+{
+    benchmark_options options;
+    if(!parse_options( argc, argv, options ))
+    {
+        cerr << "usage: gpm_plugin_benchmark --plugin <library> [--cols n] [--rows n] [--surfaces n] [--sediments n] [--steps n]"
+            " [--solver command] [--worker command] [--async] [--elastic] [--dir path] [--json file]" << endl;
+        return 2;
+    }
+
+    plugin_driver plugin( options );
+    if(!plugin.load( ))
+    {
+        cerr << "cannot load plugin " << options.plugin << endl;
+        return 1;
+    }
+
+    map<string, double> phases;
+    phase_timer timer;
+    string error;
+    bool ok = true;
+
+    phases["create"] = timer.time( [&]( ) { plugin.create( ); } );
+    phases["read_parameters"] = timer.time( [&]( ) { ok = plugin.read_parameters( "gpm_plugin_benchmark.json", error ); } );
+    if(!ok)
+    {
+        cerr << "read_parameters failed: " << error << endl;
+        return 1;
+    }
+
+    phases["setup"] = timer.time( [&]( ) { plugin.setup( ); } );
+
+    if(!plugin.resolve_attributes( error ))
+    {
+        cerr << "missing attributes: " << error << endl;
+        return 1;
+    }
+
+    //drive the display steps
+    vector<step_timing> steps;
+    for(size_t step = 0; step < options.nsteps; step++)
+    {
+        step_timing timing;
+        timing.nsurfaces = plugin.num_surfaces( step );
+
+        phases["deposit"] += timer.time( [&]( ) { plugin.deposit( step ); } );
+
+        plugin.initialize_display( step );
+        timing.process = timer.time( [&]( ) { timing.process_code = plugin.process( step ); } );
+        timing.update = timer.time( [&]( ) { timing.update_code = plugin.update( step ); } );
+
+        phases["process_model_timestep"] += timing.process;
+        phases["update_attributes_timestep"] += timing.update;
+        steps.push_back( timing );
+
+        cerr << "[gpm_plugin_benchmark] step " << step << " surfaces " << timing.nsurfaces << " process " << timing.process
+            << " s update " << timing.update << " s" << endl;
+    }
+
+    phases["delete"] = timer.time( [&]( ) { plugin.destroy( ); } );
+
+    //report
+    double total_nodes = 0.0, coupled_time = 0.0;
+    for(const auto& s : steps)
+    {
+        total_nodes += (double)s.nsurfaces * plugin.model( ).nodes_per_surface( );
+        coupled_time += s.process + s.update;
+    }
+    auto [peak_self, peak_children] = peak_memory_mb( );
+
+    stringstream json;
+    json << "{\n"
+        << "  \"plugin\": \"" << options.plugin << "\",\n"
+        << "  \"model\": { \"cols\": " << options.ncols << ", \"rows\": " << options.nrows << ", \"surfaces\": " << options.nsurfaces
+        << ", \"sediments\": " << options.nsediments << ", \"steps\": " << options.nsteps << " },\n"
+        << "  \"solver\": \"" << (options.worker.empty( ) ? options.solver : options.worker) << "\",\n"
+        << "  \"phases_s\": {";
+    for(auto it = phases.begin( ); it != phases.end( ); ++it)
+        json << (it == phases.begin( ) ? " " : ", ") << "\"" << it->first << "\": " << it->second;
+    json << " },\n"
+        << "  \"steps\": [\n";
+    for(size_t n = 0; n < steps.size( ); n++)
+    {
+        const auto& s = steps[n];
+        json << "    { \"step\": " << n << ", \"surfaces\": " << s.nsurfaces << ", \"process_s\": " << s.process << ", \"update_s\": " << s.update
+            << ", \"nodes_per_s\": " << (double)s.nsurfaces * plugin.model( ).nodes_per_surface( ) / std::max( 1.0e-9, s.process + s.update )
+            << ", \"process_code\": " << s.process_code << ", \"update_code\": " << s.update_code << " }" << (n + 1 < steps.size( ) ? "," : "") << "\n";
+    }
+    json << "  ],\n"
+        << "  \"nodes_per_s\": " << total_nodes / std::max( 1.0e-9, coupled_time ) << ",\n"
+        << "  \"peak_rss_mb\": " << peak_self << ",\n"
+        << "  \"peak_rss_solver_mb\": " << peak_children << "\n"
+        << "}\n";
+
+    if(options.json.empty( )) cout << json.str( );
+    else ofstream( options.json ) << json.str( );
+
+    bool failed = any_of( steps.begin( ), steps.end( ), []( const step_timing& s ) { return s.process_code != 0 || s.update_code != 0; } );
+    return failed ? 1 : 0;
+}
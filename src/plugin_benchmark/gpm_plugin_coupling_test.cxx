@@ -0,0 +1,109 @@
+// Coupling tests: loads a GPM plugin library, drives a small synthetic model through a few display steps
+// and checks that every process_model/update_attributes call of the plugin succeeds.
+//
+//     gpm_plugin_coupling_test --plugin <library> [--solver "visage_emulator {snapshot} {xfile}"] [--dir <work directory>]
+//
+// sync:  the solver runs in process_model, update_attributes only collects the results
+// async: the solver is launched in process_model and waited for in update_attributes
+// trigger: every other step is solved, the steps in between reuse the last results
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "gpm_plugin_driver.h"
+
+using namespace std;
+
+namespace {
+
+    struct test_case
+    {
+        string name;
+        function<void( driver_options& )> configure;
+    };
+
+    //one plugin handle over every step of the model. The first failing call is reported
+    bool run_case( const test_case& test, driver_options options )
+    {
+        test.configure( options );
+        plugin_driver plugin( options );
+        if(!plugin.load( ))
+        {
+            cerr << "cannot load plugin " << options.plugin << endl;
+            return false;
+        }
+
+        string error;
+        plugin.create( );
+        bool ok = plugin.read_parameters( "gpm_plugin_coupling_test.json", error );
+        if(ok)
+        {
+            plugin.setup( );
+            ok = plugin.resolve_attributes( error );
+        }
+
+        for(size_t step = 0; ok && step < options.nsteps; step++)
+        {
+            plugin.deposit( step );
+            plugin.initialize_display( step );
+            if(plugin.process( step ) != 0)
+            {
+                error = "process_model failed at step " + to_string( step ) + ": " + plugin.last_message( );
+                ok = false;
+            }
+            else if(plugin.update( step ) != 0)
+            {
+                error = "update_attributes failed at step " + to_string( step ) + ": " + plugin.last_message( );
+                ok = false;
+            }
+        }
+        plugin.destroy( );
+
+        cout << "[gpm_plugin_coupling_test] " << test.name << ": " << (ok ? "passed" : "FAILED " + error) << endl;
+        return ok;
+    }
+}
+
+int main( int argc, char* argv[] )
+{
+    driver_options options;
+    options.ncols = options.nrows = 12;
+    options.nsurfaces = 6;
+    options.nsediments = 2;
+    options.nsteps = 4;
+
+    for(int n = 1; n < argc; n++)
+    {
+        string arg = argv[n];
+        auto next = [&]( ) -> string { return n + 1 < argc ? argv[++n] : ""; };
+
+        if(arg == "--plugin") options.plugin = next( );
+        else if(arg == "--solver") options.solver = next( );
+        else if(arg == "--dir") options.dir = next( );
+        else
+        {
+            cerr << "unknown option " << arg << endl;
+            return 2;
+        }
+    }
+    if(options.plugin.empty( ))
+    {
+        cerr << "usage: gpm_plugin_coupling_test --plugin <library> [--solver command] [--dir path]" << endl;
+        return 2;
+    }
+
+    vector<test_case> tests =
+    {
+        { "sync", []( driver_options& o ) { o.async_solver = false; } },
+        { "async", []( driver_options& o ) { o.async_solver = true; } },
+        { "trigger", []( driver_options& o ) { o.parameters["TriggerMaxInterval"] = "2"; } },
+    };
+
+    int failed = 0;
+    for(const test_case& test : tests)
+        if(!run_case( test, options )) failed += 1;
+
+    return failed == 0 ? 0 : 1;
+}
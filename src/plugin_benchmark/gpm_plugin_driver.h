@@ -0,0 +1,400 @@
+// Drives a GPM plugin library the way GPM does: the gpm_plugin_api_* entry points resolved by name, a synthetic
+// model that deposits layers, the parameter file, then process_model/update_attributes every display step.
+// Shared by the benchmark and the coupling tests.
+
+#ifndef GPM_PLUGIN_DRIVER_H_
+#define GPM_PLUGIN_DRIVER_H_ 1
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <cstdint>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include "gpm_plugin_description.h"
+
+using namespace std;
+
+struct driver_options
+{
+    string plugin;
+    size_t ncols = 100, nrows = 100, nsurfaces = 50, nsediments = 4, nsteps = 10;
+    string solver = "visage_emulator {snapshot} {xfile}";
+    string worker;
+    bool async_solver = false;
+    bool elastic = false;
+    string dir = ".";
+    map<string, string> parameters; //more PARAMETERS of the parameter file: name, json value
+};
+
+//the plugin entry points, resolved by name
+class plugin_library
+{
+public:
+
+    bool load( const string& file_name )
+    {
+#ifdef WIN32
+        _lib = (void*)LoadLibraryA( file_name.c_str( ) );
+#else
+        _lib = dlopen( file_name.c_str( ), RTLD_NOW | RTLD_LOCAL );
+#endif
+        if(_lib == nullptr) return false;
+
+        return resolve( create, "gpm_plugin_api_create_plugin_handle" )
+            && resolve( destroy, "gpm_plugin_api_delete_plugin_handle" )
+            && resolve( read_parameters, "gpm_plugin_api_read_parameters" )
+            && resolve( install_dir, "gpm_plugin_api_current_install_directory" )
+            && resolve( set_model_extents, "gpm_plugin_api_set_model_extents" )
+            && resolve( set_sediments, "gpm_plugin_api_set_sediments" )
+            && resolve( get_needed_attributes, "gpm_plugin_api_get_needed_model_attributes" )
+            && resolve( get_write_attribute_num, "gpm_plugin_api_get_write_model_attribute_num" )
+            && resolve( get_write_attribute_sizes, "gpm_plugin_api_get_write_model_attribute_sizes" )
+            && resolve( get_write_attributes, "gpm_plugin_api_get_write_model_attributes" )
+            && resolve( initialize_display, "gpm_plugin_api_initialize_display_step" )
+            && resolve( process_model, "gpm_plugin_api_process_model_timestep" )
+            && resolve( update_attributes, "gpm_plugin_api_update_attributes_timestep" );
+    }
+
+    create_plugin_func create = nullptr;
+    delete_plugin_func destroy = nullptr;
+    read_parameters_func read_parameters = nullptr;
+    current_install_dir_func install_dir = nullptr;
+    set_model_extents_func set_model_extents = nullptr;
+    set_sediment_func set_sediments = nullptr;
+    get_needed_model_attributes_func get_needed_attributes = nullptr;
+    get_write_model_attribute_num_func get_write_attribute_num = nullptr;
+    get_write_model_attribute_sizes_func get_write_attribute_sizes = nullptr;
+    get_write_model_attributes_func get_write_attributes = nullptr;
+    initialize_display_func initialize_display = nullptr;
+    process_model_timestep_func process_model = nullptr;
+    update_attributes_timestep_func update_attributes = nullptr;
+
+private:
+
+    template<typename F>
+    bool resolve( F& f, const char* name )
+    {
+#ifdef WIN32
+        f = reinterpret_cast<F>(GetProcAddress( (HMODULE)_lib, name ));
+#else
+        f = reinterpret_cast<F>(dlsym( _lib, name ));
+#endif
+        if(f == nullptr) cerr << "missing entry point " << name << endl;
+        return f != nullptr;
+    }
+
+    void* _lib = nullptr;
+};
+
+//one attribute as GPM holds it: a (ncols x nrows) array per surface, rows along y
+struct synthetic_attribute
+{
+    vector<vector<float>> surfaces;
+    bool top_only = false;
+};
+
+class synthetic_model
+{
+public:
+
+    synthetic_model( const driver_options& options ) : _ncols( options.ncols ), _nrows( options.nrows ), _nsediments( options.nsediments )
+    {
+        _attributes["TOP"];
+        _attributes["POR"];
+        for(size_t s = 0; s < _nsediments; s++) _attributes["SED" + to_string( s + 1 )];
+    }
+
+    vector<string> names( ) const
+    {
+        vector<string> all;
+        for(const auto& a : _attributes) all.push_back( a.first );
+        return all;
+    }
+
+    size_t num_surfaces( ) const { return _attributes.at( "TOP" ).surfaces.size( ); }
+
+    size_t nodes_per_surface( ) const { return _ncols * _nrows; }
+
+    void add_written_attribute( const string& name, bool top_only ) { _attributes[name].top_only = top_only; }
+
+    //new layers on top of the current (possibly compacted) top, smooth lateral variations
+    void deposit( size_t new_nsurfaces )
+    {
+        synthetic_attribute& top = _attributes["TOP"];
+        while(top.surfaces.size( ) < new_nsurfaces)
+        {
+            size_t k = top.surfaces.size( );
+            vector<float> z( nodes_per_surface( ), -2000.0f );
+            if(k > 0) z = top.surfaces.back( );
+            for(size_t row = 0; row < _nrows; row++)
+                for(size_t col = 0; col < _ncols; col++)
+                    z[row * _ncols + col] += k == 0 ? 0.0f : 10.0f + 5.0f * sinf( 0.05f * (col + k) ) * cosf( 0.07f * (row + k) );
+            top.surfaces.push_back( z );
+
+            vector<float> fractions( _nsediments * nodes_per_surface( ) );
+            for(size_t n = 0; n < nodes_per_surface( ); n++)
+            {
+                float sum = 0.0f;
+                for(size_t s = 0; s < _nsediments; s++)
+                {
+                    float f = 1.0f + sinf( 0.01f * n + 1.3f * s + 0.2f * k );
+                    fractions[s * nodes_per_surface( ) + n] = f;
+                    sum += f;
+                }
+                for(size_t s = 0; s < _nsediments; s++) fractions[s * nodes_per_surface( ) + n] /= sum;
+            }
+            for(size_t s = 0; s < _nsediments; s++)
+            {
+                auto first = fractions.begin( ) + s * nodes_per_surface( );
+                _attributes["SED" + to_string( s + 1 )].surfaces.emplace_back( first, first + nodes_per_surface( ) );
+            }
+
+            _attributes["POR"].surfaces.emplace_back( nodes_per_surface( ), 0.4f );
+        }
+
+        //what the plugin writes back has one array per surface too (or only the top one)
+        for(auto& a : _attributes)
+        {
+            size_t n = a.second.top_only ? 1 : new_nsurfaces;
+            a.second.surfaces.resize( n, vector<float>( nodes_per_surface( ), 0.0f ) );
+        }
+    }
+
+    //the parameter block GPM passes for the given attributes. Pointers stay valid until the next deposit
+    class parms_holder
+    {
+    public:
+        gpm_plugin_api_process_attribute_parms parms;
+        vector<vector<float*>> pointers;
+        vector<float**> attribute_pointers;
+        vector<vector<uint8_t>> constant;
+        vector<uint8_t*> constant_pointers;
+        vector<size_t> sizes;
+        vector<string> names;
+        vector<gpm_plugin_api_string_layout> name_layouts;
+        vector<char> message;
+    };
+
+    void make_parms( const vector<string>& names, const gpm_plugin_api_timespan& time, parms_holder& holder )
+    {
+        holder.names = names;
+        holder.pointers.clear( );
+        holder.constant.clear( );
+        for(const string& name : names)
+        {
+            vector<float*> surfaces;
+            for(auto& s : _attributes[name].surfaces) surfaces.push_back( s.data( ) );
+            holder.pointers.push_back( surfaces );
+            holder.constant.emplace_back( surfaces.size( ), 0 );
+        }
+
+        holder.attribute_pointers.clear( );
+        holder.constant_pointers.clear( );
+        holder.sizes.clear( );
+        holder.name_layouts.clear( );
+        for(size_t i = 0; i < names.size( ); i++)
+        {
+            holder.attribute_pointers.push_back( holder.pointers[i].data( ) );
+            holder.constant_pointers.push_back( holder.constant[i].data( ) );
+            holder.sizes.push_back( holder.pointers[i].size( ) );
+            holder.name_layouts.push_back( { const_cast<char*>(holder.names[i].data( )), holder.names[i].size( ) } );
+        }
+
+        holder.message.assign( 4096, '\0' );
+
+        gpm_plugin_api_process_attribute_parms& parms = holder.parms;
+        parms.time = time;
+        parms.attributes = holder.attribute_pointers.data( );
+        parms.is_constant = holder.constant_pointers.data( );
+        parms.num_attr_array = holder.sizes.data( );
+        parms.attr_names = holder.name_layouts.data( );
+        parms.num_attributes = names.size( );
+        parms.surface_layout = { _nrows, _ncols, (ptrdiff_t)_ncols, 1 };
+        parms.error = { holder.message.data( ), 0, holder.message.size( ), gpm_plugin_api_log_none };
+    }
+
+private:
+
+    size_t _ncols, _nrows, _nsediments;
+    map<string, synthetic_attribute> _attributes;
+};
+
+inline string parameters_json( const driver_options& options )
+{
+    stringstream json;
+    json << "{\n  \"SED_SOURCE\": [\n";
+    for(size_t s = 0; s < options.nsediments; s++)
+    {
+        json << "    { \"SEDIMENT_ID\": \"benchmark_sed" << s + 1 << "\", \"PARAMETERS\": { "
+            << "\"YOUNGMOD\": " << 1.0 + 0.5 * s << ", \"POISSONR\": 0.25, \"DENSITY\": " << 2.2 + 0.1 * s
+            << ", \"POROSITY\": " << 0.45 - 0.05 * s << ", \"COHESION\": 1.0, \"TENSILE_STRENGTH\": 0.5"
+            << ", \"StiffnessPorosityMultiplier\": \"/TABLES/0\" } }" << (s + 1 < options.nsediments ? "," : "") << "\n";
+    }
+    json << "  ],\n";
+
+    json << "  \"PARAMETERS\": {\n"
+        << "    \"SedimentComposition\": \"benchmark\",\n"
+        << "    \"WEAKENINGFACTOR\": \"/TABLES/1\",\n"
+        << "    \"LateralStrain\": \"/TABLES/2\",\n"
+        << "    \"enforce_elastic\": " << (options.elastic ? "true" : "false") << ",\n"
+        << "    \"async_solver\": " << (options.async_solver ? "true" : "false") << ",\n"
+        << "    \"SolverCommand\": \"" << options.solver << "\",\n";
+    if(!options.worker.empty( ))
+        json << "    \"SolverWorker\": \"" << options.worker << "\",\n";
+    for(const auto& [name, value] : options.parameters)
+        json << "    \"" << name << "\": " << value << ",\n";
+    json << "    \"ModelPath\": \"" << options.dir << "\"\n  },\n";
+
+    json << "  \"TABLES\": [\n"
+        << "    { \"NAME\": \"StiffnessPorosity\", \"VALUES\": [ [ 0.0, 0.2, 0.4, 0.6, 1.0 ], [ 5.0, 2.5, 1.0, 0.5, 0.1 ] ] },\n"
+        << "    { \"NAME\": \"Weakening\", \"VALUES\": [ [ 0.0, 0.01, 0.1, 1.0 ], [ 1.0, 0.9, 0.7, 0.5 ] ] },\n"
+        << "    { \"NAME\": \"LateralStrain\", \"VALUES\": [ [ 0.0, 1.0e7 ], [ 0.0, 0.0 ] ] }\n"
+        << "  ]\n}\n";
+
+    return json.str( );
+}
+
+//one plugin handle driven over the display steps of the synthetic model
+class plugin_driver
+{
+public:
+
+    plugin_driver( const driver_options& options ) : _options( options ), _model( options ) {}
+
+    bool load( ) { return _plugin.load( _options.plugin ); }
+
+    void create( ) { _handle = _plugin.create( ); }
+
+    void destroy( )
+    {
+        if(_handle != nullptr) _plugin.destroy( _handle );
+        _handle = nullptr;
+    }
+
+    //writes the parameter file (parameters_json) into the model directory and hands it to the plugin
+    bool read_parameters( const string& file_name, string& error )
+    {
+        string parameters_file = _options.dir + "/" + file_name;
+        {
+            ofstream out( parameters_file );
+            out << parameters_json( _options );
+        }
+
+        _plugin.install_dir( _handle, _options.dir.c_str( ), (int)_options.dir.size( ) );
+        return check( _plugin.read_parameters( _handle, parameters_file.c_str( ), (int)parameters_file.size( ), &_error ), error );
+    }
+
+    //extents (100 m spacing) and sediments
+    void setup( )
+    {
+        float dx = 100.0f, dy = 100.0f;
+        float lx = dx * (_options.ncols - 1), ly = dy * (_options.nrows - 1);
+        gpm_plugin_api_model_definition definition = { _options.nrows, _options.ncols, { 0.0f, lx, lx, 0.0f }, { 0.0f, 0.0f, ly, ly } };
+        _plugin.set_model_extents( _handle, &definition );
+
+        vector<string> ids, names;
+        for(size_t s = 0; s < _options.nsediments; s++)
+        {
+            ids.push_back( "benchmark_sed" + to_string( s + 1 ) );
+            names.push_back( "SED" + to_string( s + 1 ) );
+        }
+        vector<gpm_plugin_api_sediment_definition> seds;
+        for(size_t s = 0; s < _options.nsediments; s++)
+            seds.push_back( { ids[s].c_str( ), ids[s].size( ), names[s].c_str( ), names[s].size( ), (ptrdiff_t)s } );
+        _plugin.set_sediments( _handle, seds.data( ), (int)seds.size( ) );
+    }
+
+    //what the plugin reads and what it writes back
+    bool resolve_attributes( string& error )
+    {
+        vector<string> available = _model.names( );
+        vector<gpm_plugin_api_string_layout> available_layouts;
+        for(string& name : available) available_layouts.push_back( { const_cast<char*>(name.data( )), name.size( ) } );
+        vector<int> needed( available.size( ), 0 );
+        if(!check( _plugin.get_needed_attributes( _handle, (int)available.size( ), available_layouts.data( ), needed.data( ), &_error ), error )) return false;
+
+        _read_names.clear( );
+        for(size_t n = 0; n < available.size( ); n++)
+            if(needed[n]) _read_names.push_back( available[n] );
+
+        int nwrite = _plugin.get_write_attribute_num( _handle );
+        vector<int> lengths( nwrite ), top_only( nwrite );
+        _plugin.get_write_attribute_sizes( _handle, lengths.data( ), nwrite );
+        _write_names.clear( );
+        vector<gpm_plugin_api_string_layout> write_layouts;
+        for(int n = 0; n < nwrite; n++) _write_names.push_back( string( lengths[n], ' ' ) );
+        for(string& name : _write_names) write_layouts.push_back( { &name[0], name.size( ) } );
+        _plugin.get_write_attributes( _handle, write_layouts.data( ), top_only.data( ), nwrite );
+        for(int n = 0; n < nwrite; n++)
+        {
+            _write_names[n].resize( write_layouts[n].str_length );
+            _model.add_written_attribute( _write_names[n], top_only[n] != 0 );
+        }
+        return true;
+    }
+
+    //the model grows from one to nsurfaces surfaces over the nsteps display steps
+    size_t num_surfaces( size_t step ) const { return 1 + ((_options.nsurfaces - 1) * (step + 1)) / _options.nsteps; }
+
+    gpm_plugin_api_timespan time_span( size_t step ) const
+    {
+        return { -1.0e6 * (_options.nsteps - step), -1.0e6 * (_options.nsteps - step - 1) };
+    }
+
+    void deposit( size_t step ) { _model.deposit( num_surfaces( step ) ); }
+
+    void initialize_display( size_t step ) { _plugin.initialize_display( _handle, time_span( step ).end ); }
+
+    int process( size_t step )
+    {
+        _model.make_parms( _read_names, time_span( step ), _read_parms );
+        int ret = _plugin.process_model( _handle, &_read_parms.parms );
+        _last_message.assign( _read_parms.parms.error.message, _read_parms.parms.error.message_length );
+        return ret;
+    }
+
+    int update( size_t step )
+    {
+        _model.make_parms( _write_names, time_span( step ), _write_parms );
+        int ret = _plugin.update_attributes( _handle, &_write_parms.parms );
+        _last_message.assign( _write_parms.parms.error.message, _write_parms.parms.error.message_length );
+        return ret;
+    }
+
+    //what the plugin wrote in the last process or update call
+    const string& last_message( ) const { return _last_message; }
+
+    synthetic_model& model( ) { return _model; }
+
+private:
+
+    bool check( int ret, string& error )
+    {
+        if(ret != 0) error += string( _error.message, _error.message_length );
+        return ret == 0;
+    }
+
+    driver_options _options;
+    plugin_library _plugin;
+    synthetic_model _model;
+    void* _handle = nullptr;
+
+    vector<char> _message = vector<char>( 4096, '\0' );
+    gpm_plugin_api_message_definition _error = { _message.data( ), 0, _message.size( ), gpm_plugin_api_log_none };
+
+    vector<string> _read_names, _write_names;
+    synthetic_model::parms_holder _read_parms, _write_parms;
+    string _last_message;
+};
+
+#endif
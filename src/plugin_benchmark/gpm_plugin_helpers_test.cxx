@@ -0,0 +1,83 @@
+// Attribute holder cache test: the plugin keeps one array_holder_cache per call kind (process_model gets the
+// attributes the process needs, update_attributes the ones it writes). Over a growing model each cache must be
+// built once and then only follow the surface pointers, and the holders must see the host's arrays.
+//
+//     gpm_plugin_helpers_test [--steps 5]
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gpm_plugin_helpers.h"
+#include "gpm_plugin_driver.h"
+
+using namespace std;
+
+namespace {
+
+    //every holder of the map reads the surface the host passed
+    bool holders_match( const Slb::Exploration::Gpm::Api::array_holder_cache::holder_map& holders, const gpm_plugin_api_process_attribute_parms& parms )
+    {
+        for(size_t i = 0; i < parms.num_attributes; i++)
+        {
+            string name( parms.attr_names[i].str, parms.attr_names[i].str_length );
+            auto it = holders.find( name );
+            if(it == holders.end( ) || it->second.size( ) != parms.num_attr_array[i]) return false;
+            for(size_t j = 0; j < parms.num_attr_array[i]; j++)
+                if(&it->second[j]( 0, 0 ) != parms.attributes[i][j]) return false;
+        }
+        return true;
+    }
+}
+
+int main( int argc, char* argv[] )
+{
+    driver_options options;
+    options.ncols = 8;
+    options.nrows = 6;
+    options.nsediments = 2;
+    options.nsteps = 5;
+    for(int n = 1; n < argc; n++)
+    {
+        string arg = argv[n];
+        if(arg == "--steps" && n + 1 < argc) options.nsteps = stoul( argv[++n] );
+        else
+        {
+            cerr << "usage: gpm_plugin_helpers_test [--steps n]" << endl;
+            return 2;
+        }
+    }
+
+    synthetic_model model( options );
+    const vector<string> needed = model.names( );
+    const vector<string> written = { "POR", "STRESSZZ" };
+    model.add_written_attribute( "STRESSZZ", false );
+
+    Slb::Exploration::Gpm::Api::array_holder_cache needed_attributes, update_attributes;
+    synthetic_model::parms_holder read_parms, write_parms;
+
+    int failed = 0;
+    for(size_t step = 0; step < options.nsteps; step++)
+    {
+        model.deposit( 2 + step );
+        gpm_plugin_api_timespan time = { (double)step, (double)step + 1.0 };
+        model.make_parms( needed, time, read_parms );
+        model.make_parms( written, time, write_parms );
+
+        if(!holders_match( needed_attributes.update( read_parms.parms ), read_parms.parms )
+            || !holders_match( update_attributes.update( write_parms.parms ), write_parms.parms ))
+        {
+            cout << "[gpm_plugin_helpers_test] step " << step << ": holders do not point at the host arrays" << endl;
+            failed += 1;
+        }
+        if(needed_attributes.rebuilds( ) != 1 || update_attributes.rebuilds( ) != 1)
+        {
+            cout << "[gpm_plugin_helpers_test] step " << step << ": rebuilt (" << needed_attributes.rebuilds( ) << " needed, "
+                << update_attributes.rebuilds( ) << " update)" << endl;
+            failed += 1;
+        }
+    }
+
+    cout << "[gpm_plugin_helpers_test] " << (failed == 0 ? "passed" : "FAILED") << endl;
+    return failed == 0 ? 0 : 1;
+}
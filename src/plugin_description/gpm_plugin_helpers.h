@@ -6,6 +6,8 @@
 #include "gpm_plugin_description.h"
 #include <vector>
 #include <map>
+#include <string>
+#include <algorithm>
 #include <cstddef>
 #include <cassert>
 
@@ -127,6 +129,137 @@ namespace Slb {
                     return res;
                 }
 
+                // make_array_holders kept between calls.
+                // The host passes the same attributes every call, with more surfaces as the model grows and the
+                // same memory unless it reallocates. update() only appends holders for new surfaces and
+                // replaces the ones whose base address (or constness) changed; the map is rebuilt only when the
+                // attribute list or the surface layout changes.
+                class array_holder_cache {
+                public:
+                    typedef std::map<std::string, std::vector<array_2d_indexer<float>>> holder_map;
+
+                    // how the surfaces of an attribute sit in memory
+                    struct attribute_layout {
+                        bool contiguous_surfaces{};  // every surface is one dense row-major block
+                        bool single_block{};         // and the surfaces follow each other: one block for the whole attribute
+                        bool any_constant{};
+                        float* first{};              // first value of surface 0
+                    };
+
+                    // the holders may be written through, and callers may add keys (the next update rebuilds then)
+                    holder_map& update( const gpm_plugin_api_process_attribute_parms& attrs )
+                    {
+                        if(!same_attributes( attrs )) rebuild( attrs );
+
+                        for(size_t i = 0; i < attrs.num_attributes; ++i) {
+                            entry& e = _entries[i];
+                            auto& holders = *e.holders;
+                            bool changed = false;
+                            for(size_t j = 0; j < attrs.num_attr_array[i]; ++j) {
+                                float* base = attrs.attributes[i][j];
+                                bool constant = attrs.is_constant[i][j] != 0;
+                                if(j < e.bases.size( ) && e.bases[j] == base && e.constant[j] == constant) continue;
+
+                                array_2d_indexer<float> holder( base, constant ? _const_layout : attrs.surface_layout );
+                                if(j < holders.size( )) {
+                                    holders[j] = holder;
+                                    e.bases[j] = base;
+                                    e.constant[j] = constant;
+                                }
+                                else {
+                                    holders.push_back( holder );
+                                    e.bases.push_back( base );
+                                    e.constant.push_back( constant );
+                                }
+                                changed = true;
+                            }
+                            if(holders.size( ) > attrs.num_attr_array[i]) {
+                                holders.erase( holders.begin( ) + attrs.num_attr_array[i], holders.end( ) );
+                                e.bases.resize( attrs.num_attr_array[i] );
+                                e.constant.resize( attrs.num_attr_array[i] );
+                                changed = true;
+                            }
+                            if(changed) e.layout = describe( e );
+                        }
+                        return _holders;
+                    }
+
+                    const holder_map& holders( ) const { return _holders; }
+
+                    // layout of the attribute as of the last update (all false if unknown)
+                    attribute_layout layout( const std::string& name ) const
+                    {
+                        for(const entry& e : _entries)
+                            if(e.name == name) return e.layout;
+                        return attribute_layout( );
+                    }
+
+                    // number of full map rebuilds so far (1 for a host that never changes its attribute list)
+                    size_t rebuilds( ) const { return _rebuilds; }
+
+                private:
+                    struct entry {
+                        std::string name;
+                        std::vector<array_2d_indexer<float>>* holders{};
+                        std::vector<float*> bases;
+                        std::vector<bool> constant;
+                        attribute_layout layout;
+                    };
+
+                    static bool same_layout( const gpm_plugin_api_2d_memory_layout& a, const gpm_plugin_api_2d_memory_layout& b )
+                    {
+                        return a.num_rows == b.num_rows && a.num_cols == b.num_cols && a.row_stride == b.row_stride && a.col_stride == b.col_stride;
+                    }
+
+                    // same names in the same order, same surface layout, and nobody added keys to the map
+                    bool same_attributes( const gpm_plugin_api_process_attribute_parms& attrs ) const
+                    {
+                        if(attrs.num_attributes != _entries.size( ) || _holders.size( ) != _entries.size( )) return false;
+                        if(!same_layout( attrs.surface_layout, _surface_layout )) return false;
+                        for(size_t i = 0; i < attrs.num_attributes; ++i) {
+                            const std::string& name = _entries[i].name;
+                            if(name.size( ) != attrs.attr_names[i].str_length || name.compare( 0, name.size( ), attrs.attr_names[i].str, attrs.attr_names[i].str_length ) != 0)
+                                return false;
+                        }
+                        return true;
+                    }
+
+                    void rebuild( const gpm_plugin_api_process_attribute_parms& attrs )
+                    {
+                        _holders.clear( );
+                        _entries.clear( );
+                        _entries.resize( attrs.num_attributes );
+                        _surface_layout = attrs.surface_layout;
+                        _const_layout = attrs.surface_layout;
+                        _const_layout.col_stride = 0;
+                        _const_layout.row_stride = 0;
+                        for(size_t i = 0; i < attrs.num_attributes; ++i) {
+                            _entries[i].name.assign( attrs.attr_names[i].str, attrs.attr_names[i].str_length );
+                            _entries[i].holders = &_holders[_entries[i].name];
+                        }
+                        _rebuilds += 1;
+                    }
+
+                    attribute_layout describe( const entry& e ) const
+                    {
+                        attribute_layout l;
+                        const size_t nrows = _surface_layout.num_rows, ncols = _surface_layout.num_cols;
+                        l.first = e.bases.empty( ) ? nullptr : e.bases[0];
+                        l.any_constant = std::find( e.constant.begin( ), e.constant.end( ), true ) != e.constant.end( );
+                        l.contiguous_surfaces = !l.any_constant && _surface_layout.col_stride == 1 && _surface_layout.row_stride == (ptrdiff_t)ncols;
+                        l.single_block = l.contiguous_surfaces;
+                        for(size_t j = 1; j < e.bases.size( ) && l.single_block; ++j)
+                            l.single_block = e.bases[j] == e.bases[j - 1] + nrows * ncols;
+                        return l;
+                    }
+
+                    holder_map _holders;
+                    std::vector<entry> _entries;  // host order
+                    gpm_plugin_api_2d_memory_layout _surface_layout{};
+                    gpm_plugin_api_2d_memory_layout _const_layout{};
+                    size_t _rebuilds{};
+                };
+
                 inline std::vector<sediment_descr_type>
                     make_sediment_descriptions( gpm_plugin_api_sediment_definition* seds, int num_seds )
                 {
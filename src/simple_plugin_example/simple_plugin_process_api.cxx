@@ -27,7 +27,24 @@ namespace {
         std::shared_ptr<gpm_visage_link> process;
         std::shared_ptr<IConfiguration> config;
         shared_ptr<IMechanicalPropertiesInitializer> props_model;
+
+        //attribute holders kept across steps, one cache per call kind: process_model gets the attributes
+        //the process needs, update_attributes the ones it writes, and each list stays the same from step to step
+        Slb::Exploration::Gpm::Api::array_holder_cache needed_attributes;
+        Slb::Exploration::Gpm::Api::array_holder_cache update_attributes;
     };
+
+    //log of a call to the host's message channel, cut to the space the host gave
+    void write_log( const std::string& log, gpm_plugin_api_message_definition& msg )
+    {
+        msg.log_level = gpm_plugin_api_log_normal;
+        if(log.empty( ) || msg.message == nullptr) return;
+
+        std::string tmp = log + "\n";
+        size_t n = msg.message_array_length > 0 ? std::min( tmp.size( ), msg.message_array_length ) : tmp.size( );
+        std::copy( tmp.begin( ), tmp.begin( ) + n, msg.message );
+        msg.message_length = n;
+    }
 }
 
 extern "C" DLLEXPORT void* gpm_plugin_api_create_plugin_handle( )
@@ -215,6 +232,12 @@ extern "C" DLLEXPORT void gpm_plugin_api_get_write_model_attributes( void* handl
     }
 }
 
+// Every display step: the coupler itself decides whether the step needs a solve (see CouplingTrigger)
+extern "C" DLLEXPORT int gpm_plugin_api_process_model_multiple_of_timestep( void*, double )
+{
+    return 1;
+}
+
 // Run a display time step with the attributes we said we need
 // Typically means that we take the geometry and transform to an unstractured grid
 // Run the simulation needed
@@ -223,10 +246,11 @@ extern "C" DLLEXPORT void gpm_plugin_api_get_write_model_attributes( void* handl
 extern "C" DLLEXPORT int gpm_plugin_api_process_model_timestep( void* handle, gpm_plugin_api_process_attribute_parms * params )
 {
     std::shared_ptr<gpm_visage_link>   ptr = get_process_wrapper( handle )->process;
-    const auto attrs = Slb::Exploration::Gpm::Api::make_array_holders( *params );
+    const auto& attrs = get_process_wrapper( handle )->needed_attributes.update( *params );
     std::string log;
 
     const int res = ptr->run_timestep( attrs, log, params->time );
+    write_log( log, params->error ); //progress and eta of the run
     return res;
 
     //ptr->update_geometry_from_top_property(attrs);
@@ -261,19 +285,12 @@ extern "C" DLLEXPORT int gpm_plugin_api_process_model_timestep( void* handle, gp
 //Here, we take the results from the Geomechanics simulation and copy the results into the gpm arrays.
 extern "C" DLLEXPORT int gpm_plugin_api_update_attributes_timestep( void* handle, gpm_plugin_api_process_attribute_parms * parms )
 {
-    auto attrs = Slb::Exploration::Gpm::Api::make_array_holders( *parms );
-    std::map<std::string, std::vector<Slb::Exploration::Gpm::Api::array_2d_indexer<float>>> ATT2 = Slb::Exploration::Gpm::Api::make_array_holders( *parms );
-
     const auto ptr = get_process_wrapper( handle );
+    auto& attrs = ptr->update_attributes.update( *parms );
 
     std::string log = "";
     const int res = ptr->process->update_results( attrs, log );
-    parms->error.log_level = gpm_plugin_api_log_normal;
-    if(!log.empty( )) {
-        std::string tmp = log + "\n";
-        std::copy( tmp.begin( ), tmp.end( ), parms->error.message );
-        parms->error.message_length = tmp.size( );
-    }
+    write_log( log, parms->error );
 
     return res;
 
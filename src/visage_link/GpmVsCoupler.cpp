@@ -1,5 +1,7 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
 #include <string>
 #include <iterator>
 #include <algorithm>
@@ -23,6 +25,24 @@
 
 using namespace std;
 
+namespace {
+    //what a checkpoint does not store and a restart must find unchanged: the sediments and the tables of the
+    //parameters file (the rest, e.g. RestartFrom itself or the solver command, may change between the runs)
+    string restart_state_text( const UIParameters& params )
+    {
+        stringstream text;
+        text << setprecision( 9 );
+        for(const auto& [key, sed] : params.sediments)
+        {
+            text << key << " " << sed.id << "\n";
+            for(const auto& [name, value] : sed.properties) text << name << "=" << value << "\n";
+            text << sed.compaction_table << "\n";
+        }
+        text << params.plasticity_multiplier << "\n" << params.strain_function << "\n";
+        return text.str( );
+    }
+}
+
 
 vector<pair<string, bool>> gpm_visage_link::list_needed_attribute_names( const vector<string>& from_all_atts ) const
 {
@@ -52,6 +72,36 @@ std::vector<gpm_visage_link::property_type> gpm_visage_link::list_wanted_attribu
     return atts;
 }
 
+set<string> gpm_visage_link::list_required_result_names( ) const
+{
+    set<string> names = _mech_props_model->required_result_names( );
+
+    for(const auto& att : list_wanted_attribute_names( false ))
+        if(!_derived.contains( att.name )) names.insert( att.name );
+
+    //derived results are not in the X files, their inputs are
+    set<string> derived = list_derived_result_names( );
+    set<string> inputs = _derived.input_names( derived );
+    names.insert( inputs.begin( ), inputs.end( ) );
+
+    //vertical displacements used in update_gpm_and_visage_geometris_from_visage_results
+    names.insert( { "NRCKDISZ", "ROCKDISZ" } );
+
+    //the last equilibrium the next solve starts from
+    if(_warm_start)
+        for(const auto& stress : WarmStart::stress_names( )) names.insert( stress.first );
+
+    return names;
+}
+
+set<string> gpm_visage_link::list_derived_result_names( ) const
+{
+    set<string> wanted = _mech_props_model->derived_result_names( _visage_options.enforce_elastic( ) );
+    for(const auto& att : list_wanted_attribute_names( false )) wanted.insert( att.name );
+
+    return _derived.derived_names( wanted );
+}
+
 bool gpm_visage_link::process_ui( string json_string )
 {
     optional<UIParameters> params = JsonParser::parse_json_string<UIParameters>( json_string, _visage_options, _output_array_names );//, _plasticity_multiplier, _strain_function );
@@ -59,7 +109,84 @@ bool gpm_visage_link::process_ui( string json_string )
     if(params.has_value( ))
     {
         _sediments = params->sediments;
+
+        //array handles of the sediments, so that the steps do not search the array names
+        vector<string> sediment_keys;
+        for(const auto& sed : _sediments) sediment_keys.push_back( sed.first );
+        _mech_props_model->intern_arrays( sediment_keys );
         cout << *params << endl;
+
+        _async_solver = params->flags.find( "async_solver" ) != params->flags.end( ) && params->flags.at( "async_solver" );
+        if(params->properties.find( "SolverTimeout" ) != params->properties.end( ))
+            _solver_timeout = params->properties.at( "SolverTimeout" );
+        if(params->names.find( "SolverCommand" ) != params->names.end( ))
+            _solver_command_template = params->names.at( "SolverCommand" );
+        if(params->names.find( "SolverWorker" ) != params->names.end( ))
+            _worker_command = params->names.at( "SolverWorker" );
+        if(params->names.find( "ModelPath" ) != params->names.end( ))
+            _visage_options->path( ) = params->names.at( "ModelPath" );
+        if(params->flags.find( "profile" ) != params->flags.end( ))
+            _profiler.enabled( ) = params->flags.at( "profile" );
+        if(params->names.find( "ProfileTrace" ) != params->names.end( ))
+            _profile_trace = params->names.at( "ProfileTrace" );
+        if(params->flags.find( "count_allocations" ) != params->flags.end( ))
+            _count_allocations = params->flags.at( "count_allocations" );
+        if(params->flags.find( "warm_start" ) != params->flags.end( ))
+            _warm_start = params->flags.at( "warm_start" );
+        if(params->flags.find( "remove_pinchouts" ) != params->flags.end( ))
+            _remove_pinchouts = params->flags.at( "remove_pinchouts" );
+        if(params->properties.find( "TriggerThickness" ) != params->properties.end( ))
+            _trigger.thickness_threshold( ) = params->properties.at( "TriggerThickness" );
+        if(params->properties.find( "TriggerLoad" ) != params->properties.end( ))
+            _trigger.load_threshold( ) = params->properties.at( "TriggerLoad" );
+        if(params->properties.find( "TriggerMaxInterval" ) != params->properties.end( ))
+            _trigger.max_interval( ) = (int)params->properties.at( "TriggerMaxInterval" );
+        if(params->properties.find( "RunEndTime" ) != params->properties.end( ))
+        {
+            _budget.run_end_time( ) = params->properties.at( "RunEndTime" );
+            _budget.enabled( ) = true;
+        }
+        if(params->properties.find( "BudgetHours" ) != params->properties.end( ))
+            _budget.budget_seconds( ) = 3600.0 * params->properties.at( "BudgetHours" );
+        if(params->properties.find( "BudgetMaxInterval" ) != params->properties.end( ))
+            _budget.max_interval( ) = (int)params->properties.at( "BudgetMaxInterval" );
+        if(params->properties.find( "BudgetMaxNp" ) != params->properties.end( ))
+            _budget.max_np( ) = (int)params->properties.at( "BudgetMaxNp" );
+        if(params->properties.find( "LateralCoarsening" ) != params->properties.end( ))
+            _coarsening_factor = std::max( 1, (int)params->properties.at( "LateralCoarsening" ) );
+        if(params->properties.find( "LumpThickness" ) != params->properties.end( ))
+            _lumping.thickness_threshold( ) = params->properties.at( "LumpThickness" );
+        if(params->properties.find( "LumpKeepTop" ) != params->properties.end( ))
+            _lumping.keep_top( ) = std::max( 0, (int)params->properties.at( "LumpKeepTop" ) );
+        if(params->properties.find( "CheckpointInterval" ) != params->properties.end( ))
+            _checkpoint_interval = (int)params->properties.at( "CheckpointInterval" );
+        if(params->names.find( "CheckpointFile" ) != params->names.end( ))
+            _checkpoint_file = params->names.at( "CheckpointFile" );
+        if(_checkpoint_interval > 0 && _checkpoint_file.empty( ))
+            _checkpoint_file = (filesystem::path( _visage_options->path( ) ) /= filesystem::path( _visage_options->model_name( ) + ".gvckpt" )).string( );
+
+        _ui_hash = CouplerCheckpoint::hash( restart_state_text( *params ) );
+        if(params->names.find( "RestartFrom" ) != params->names.end( ))
+        {
+            string error;
+            CouplerCheckpoint checkpoint;
+            _restart_file = params->names.at( "RestartFrom" );
+            if(CouplerCheckpoint::read( _restart_file, checkpoint, error, true ))
+            {
+                if(checkpoint.header.ui_hash != _ui_hash)
+                {
+                    //restored arrays from other sediments or tables would mix two models
+                    cout << "[process_ui] ERROR: the sediments or tables differ from the ones of the checkpoint " << _restart_file << ", restart refused" << endl;
+                    return false;
+                }
+                _restart_step = checkpoint.header.step;
+                cout << "[process_ui] restarting from step " << _restart_step << " (" << _restart_file << ")" << endl;
+            }
+            else
+            {
+                cout << error << "\n[process_ui] starting from step 0" << endl;
+            }
+        }
     }
 
     _plasticity_multiplier = params->plasticity_multiplier;
@@ -77,20 +204,21 @@ bool gpm_visage_link::update_boundary_conditions( const gpm_attribute& top )//St
     prev_base = std::move( base );
     base.reset( new StructuredSurface( _visage_options->geometry( )->get_structured_surface( 0 ) ) );
 
-    vector<float> gpm_base = get_gpm_heights( top, 0 );
+    const vector<float>& gpm_base = get_values( top, 0, 1, _scratch->get( 0 ) );
     vector<float>& base_heights = base->heights( );
     copy( gpm_base.begin( ), gpm_base.end( ), base_heights.begin( ) );
 
     //if I have and old and a new, it means that I am already getting a potentially modified
     //basement.  There is already some history. Lets figure out the displacements to be used as BC.
-    vector<float> displacement;
+    vector<float>& displacement = _scratch->get( 0 );
     DisplacementSurfaceBoundaryCondition* bc = static_cast<DisplacementSurfaceBoundaryCondition*>(_visage_options->get_boundary_condition( 2 ));
     bc->clear_displacement( );
     if(prev_base)
     {
         //lets see the basement displacement
+        displacement.resize( base->heights( ).size( ) );
         transform( begin( base->heights( ) ), end( base->heights( ) ), prev_base->heights( ).begin( ),
-                   back_inserter( displacement ), []( const float& h1, const float& h2 )
+                   begin( displacement ), []( const float& h1, const float& h2 )
                    {
                        return h1 - h2;
                    } );
@@ -99,7 +227,7 @@ bool gpm_visage_link::update_boundary_conditions( const gpm_attribute& top )//St
     else
     {
         bc->clear_displacement( );
-        displacement.resize( base->total_nodes( ), 0.0f );
+        displacement.assign( base->total_nodes( ), 0.0f );
     }
 
 
@@ -122,6 +250,7 @@ bool gpm_visage_link::update_boundary_conditions( const gpm_attribute& top )//St
 
 bool  gpm_visage_link::read_visage_results( int last_step, string& error )
 {
+    ScopedTimer timer( _profiler, "read_visage_results" );
     string file_to_parse = _vs_results_reader.get_results_file( _visage_options->model_name( ), _visage_options->path( ), last_step );
     if(file_to_parse.empty( ))
     {
@@ -129,65 +258,157 @@ bool  gpm_visage_link::read_visage_results( int last_step, string& error )
         return false;
     }
 
-    vector<string> names_in_file = _vs_results_reader.get_key_names( file_to_parse );
-    int total_read = 0;
-    if(!file_to_parse.empty( ))
+    set<string> required_names = list_required_result_names( );
+    int total_read = _vs_results_reader.read_all_results( file_to_parse, _data_arrays, &_from_visage_unit_conversion, &required_names );
+    if(total_read <= 0)
     {
+        error += "\nError parsing results from geomechanics simulation. No results read from " + file_to_parse;
+        return false;
+    }
+
+    std::error_code ec;
+    auto bytes = filesystem::file_size( file_to_parse, ec );
+    if(!ec) _profiler.count( "bytes_read", (double)bytes );
+
+    compute_derived_results( );
+    return true;
+}
 
-        for(auto name_in_file : names_in_file)
+bool  gpm_visage_link::collect_worker_results( string& error )
+{
+    ScopedTimer timer( _profiler, "collect_worker_results" );
+    set<string> required_names = list_required_result_names( );
+    string worker_error;
+    if(_worker.collect_step( _data_arrays, &_from_visage_unit_conversion, &required_names, _solver_timeout, worker_error ) < 0)
+    {
+        //the worker was stopped: the inputs of the step are untouched, the step (and the next ones) go through eclrun
+        cout << worker_error << "\nSolver worker lost, solving the step with eclrun" << endl;
+        _worker_command.clear( );
+
+        string mii_file_name = VisageDeckWritter::write_deck( &_visage_options, &_data_arrays, &_to_visage_unit_conversion );
+        if(run_visage( mii_file_name ) != 0)
         {
-            total_read += (1 - _vs_results_reader.read_result( file_to_parse, name_in_file, _data_arrays, &_from_visage_unit_conversion ));
+            error += "\nVisage run failed.  MII file: " + mii_file_name;
+            _error = true;
+            return false;
         }
+        if(!read_visage_results( _time_step, error ))
+        {
+            _error = true;
+            return false;
+        }
+        return true;
     }
 
-    //some results are derived from others. Example: eq. plastic strain. We will compute it here as well.
-    if(!_visage_options.enforce_elastic( ))
-    {
-        vector<float>& exx = _data_arrays.get_array( "PLSTRNXX" );
-        vector<float>& eyy = _data_arrays.get_array( "PLSTRNYY" );
-        vector<float>& ezz = _data_arrays.get_array( "PLSTRNZZ" );
-
-        vector<float>& exy = _data_arrays.get_array( "PLSTRNXY" );
-        vector<float>& eyz = _data_arrays.get_array( "PLSTRNYZ" );
-        vector<float>& ezx = _data_arrays.get_array( "PLSTRNZX" );
+    double bytes = 0.0;
+    for(const string& name : required_names)
+        if(_data_arrays.contains( name )) bytes += sizeof( float ) * _data_arrays.array_size( name );
+    _profiler.count( "bytes_read", bytes );
 
-        vector<float>& eq = _data_arrays.get_or_create_array( "EQPLSTRAIN" );//, 0.0f, exx.size() );
-        eq.resize( exx.size( ), 0.0f );
+    compute_derived_results( );
+    return true;
+}
 
-        float a = 2.0 / 3.0, b = 3.0 / 2.0, one_third = 1.0 / 3.0, three_quaters = 0.75f;
-        for(int n : IntRange( 0, exx.size( ) ))
-        {
-            float vxx = one_third * (2.0f * exx[n] - eyy[n] - ezz[n]);
-            float vyy = one_third * (-1.0f * exx[n] + 2.0 * eyy[n] - ezz[n]);
-            float vzz = one_third * (-1.0f * exx[n] - eyy[n] + 2.0f * ezz[n]);
+void  gpm_visage_link::compute_derived_results( )
+{
+    //only what is displayed or used by the property model (e.g. EQPLSTRAIN when plastic)
+    ScopedTimer timer( _profiler, "derived_results" );
+    string error;
+    _derived.compute( list_derived_result_names( ), _data_arrays, error );
+    if(!error.empty( )) cout << error << endl;
+}
 
-            float vxy = (exy[n] * exy[n] + eyz[n] * eyz[n] + ezx[n] * ezx[n]);
+string gpm_visage_link::solver_command( string mii_file )
+{
+    string command = replace_all( _solver_command_template, "{mii}", mii_file );
 
+    if(command.find( "{xfile}" ) != string::npos)
+    {
+        string xfile = _vs_results_reader.get_results_file( _visage_options->model_name( ), _visage_options->path( ), _time_step );
+        command = replace_all( command, "{xfile}", xfile );
+    }
 
-            eq[n] = a * sqrtf( b * (vxx * vxx + vyy * vyy + vzz * vzz) + three_quaters * vxy );
-        }
+    if(command.find( "{snapshot}" ) != string::npos)
+    {
+        string snapshot = filesystem::path( mii_file ).replace_extension( ".gvs" ).string( );
+        string error;
+        if(!VisageWorkerBackend::write_snapshot_file( snapshot, _time_step, geometry( ), _data_arrays, &_to_visage_unit_conversion, error ))
+            cout << error << endl;
+        command = replace_all( command, "{snapshot}", snapshot );
     }
-    return true;
+
+    return command;
 }
 
 int  gpm_visage_link::run_visage( string mii_file )
 {
-    std::cout << "Calling eclrun visage " << mii_file << " --np=4" << std::endl;
-    std::string command = "eclrun visage  " + mii_file + " --np=4";
+    std::string command = solver_command( mii_file );
+    std::cout << "Calling " << command << std::endl;
     int ret_code = system( command.c_str( ) );
     std::cout << "return code  " << ret_code << std::endl;
 
     return ret_code;
 }
 
-int gpm_visage_link::run_timestep( const attr_lookup_type& gpm_attributes, std::string& log, const gpm_plugin_api_timespan& time_span )
+bool gpm_visage_link::launch_visage( string mii_file )
+{
+    std::string command = solver_command( mii_file );
+    std::cout << "Launching " << command << " (results collected in update_results)" << std::endl;
+    return _solver.launch( command );
+}
+
+int  gpm_visage_link::wait_visage( string& error )
+{
+    bool timed_out = false;
+    int ret_code = _solver.wait( _solver_timeout, &timed_out );
+    std::cout << "return code  " << ret_code << std::endl;
+
+    if(timed_out)
+        error += "\nVisage run timed out after " + to_string( _solver_timeout ) + " s: " + _solver.command( );
+    else if(ret_code != 0)
+        error += "\nVisage run failed: " + _solver.command( );
+
+    if(ret_code != 0) _error = true;
+    return ret_code;
+}
+
+int gpm_visage_link::run_timestep( const attr_lookup_type& host_attributes, std::string& log, const gpm_plugin_api_timespan& time_span )
 {
     std::cout << (!_error ? "[run_timestep] run_timestep counter " + to_string( _time_step ) : "\n\n----skipping simulation of step " + to_string( _time_step ) + "--------\n\n") << endl;
     //at present, we dont have a way of stopping the GPM engine when we have an error in VS.
     if(_error) return 1;
 
-    shared_ptr<ChronoPoint> timer = make_shared<ChronoPoint>( "run_time_step" );
-   
+    //the host replays the steps before the checkpoint: nothing to solve, update_results restores the state
+    if(_restart_step >= 0 && _time_step < _restart_step)
+    {
+        gpm_time = time_span;
+        increment_step( );
+        cout << "[run_timestep] replaying step " << _time_step << " (restart at step " << _restart_step << ")" << endl;
+        return 0;
+    }
+
+    _profiler.begin_step( _time_step < 0 ? 0 : _time_step + 1 );
+    ScopedTimer timer( _profiler, "run_timestep" );
+
+    //coarsened: the step runs on the gpm attributes restricted to the visage grid
+    const attr_lookup_type& gpm_attributes = _coarsening.enabled( ) ? _coarsening.restrict_attributes( host_attributes ) : host_attributes;
+
+    if(_budget.enabled( ))
+    {
+        //settings for the steps left, from the cost of the steps so far
+        _budget.begin_step( time_span );
+        int np = BudgetPlanner::command_np( _solver_command_template );
+        BudgetPlanner::plan_type plan = _budget.plan( np );
+        if(plan.fitted)
+        {
+            _trigger.min_interval( ) = plan.interval;
+            if(plan.np != np) _solver_command_template = BudgetPlanner::with_np( _solver_command_template, plan.np );
+        }
+        string report = _budget.report( plan );
+        cout << report << endl;
+        log += report + "\n";
+    }
+
     StructuredGrid& geometry = _visage_options->geometry( );
     const gpm_attribute& top = gpm_attributes.at( "TOP" );
     gpm_time = time_span;
@@ -202,11 +423,13 @@ int gpm_visage_link::run_timestep( const attr_lookup_type& gpm_attributes, std::
         geometry->set_num_surfaces( new_num_surfaces );
         for(auto k : IntRange( 0, new_num_surfaces ))
         {
-            auto [it1, it2] = const_att_iterator::surface_range( top, k );
-            std::copy( it1, it2, geometry->begin_surface( k ) );
+            const_att_iterator::copy_surfaces( top, k, k + 1, geometry->begin_surface( k ) );
         }
 
-        _mech_props_model->update_initial_mech_props( gpm_attributes, _sediments, _visage_options, _data_arrays, 0, new_num_surfaces );
+        {
+            ScopedTimer props_timer( _profiler, "property_update" );
+            _mech_props_model->update_initial_mech_props( gpm_attributes, _sediments, _visage_options, _data_arrays, 0, new_num_surfaces );
+        }
         old_num_surfaces = new_num_surfaces;
 
         try {
@@ -225,47 +448,147 @@ int gpm_visage_link::run_timestep( const attr_lookup_type& gpm_attributes, std::
 
 
 
-    update_boundary_conditions( top );
+    {
+        ScopedTimer geometry_timer( _profiler, "geometry" );
+
+        //add the new surface(s) preserving gpm thickness deposited. 
+        vector<float>& nodal_thickness = _scratch->get( top[0].num_cols( ) * top[0].num_rows( ) );
+        for(int k : IntRange( old_num_surfaces, new_num_surfaces ))
+        {
+            geometry->set_num_surfaces( 1 + geometry->nsurfaces( ) ); //old surfaces not modified, new not initialized.
+
+            nodal_thickness.resize( top[0].num_cols( ) * top[0].num_rows( ) );
+            auto [beg_above, end_above, beg_below] = const_att_iterator::surface_range( top, k, k - 1 );
+            std::transform( beg_above, end_above, beg_below, begin( nodal_thickness ), []( float h1, float h2 ) { return fabs( h1 - h2 ); } );//  std::minus<float>( ) );
+            const auto& zbelow = geometry->get_local_depths( k - 1 );
+            auto& zabove = geometry->get_local_depths( k );
+
+            float zmax = -9999999.99f;
+            for(int n : IntRange( 0, zabove.size( ) ))
+            {
+                zabove[n] = zbelow[n] + nodal_thickness[n];
+                if(zabove[n] > zmax) zmax = zabove[n];
+            }
+
+        }
+    }
 
-    //add the new surface(s) preserving gpm thickness deposited. 
-    vector<float> nodal_thickness;
-    for(int k : IntRange( old_num_surfaces, new_num_surfaces ))
     {
-        geometry->set_num_surfaces( 1 + geometry->nsurfaces( ) ); //old surfaces not modified, new not initialized.
+        ScopedTimer props_timer( _profiler, "property_update" );
+        _mech_props_model->update_initial_mech_props( gpm_attributes, _sediments, _visage_options, _data_arrays, old_num_surfaces, new_num_surfaces );
+    }
 
-        nodal_thickness.resize( top[0].num_cols( ) * top[0].num_rows( ) );
-        auto [beg_above, end_above, beg_below] = const_att_iterator::surface_range( top, k, k - 1 );
-        std::transform( beg_above, end_above, beg_below, begin( nodal_thickness ), []( float h1, float h2 ) { return fabs( h1 - h2 ); } );//  std::minus<float>( ) );
-        const auto& zbelow = geometry->get_local_depths( k - 1 );
-        auto& zabove = geometry->get_local_depths( k );
+    if(_trigger.enabled( ))
+    {
+        ScopedTimer trigger_timer( _profiler, "trigger" );
+        _solve_skipped = !_trigger.due( geometry, transfer( ), _data_arrays );
+        cout << "[run_timestep] load change since the last solve: thickness " << _trigger.max_thickness_change( ) << " m, overburden "
+            << _trigger.max_load_change( ) << " MPa, " << _trigger.steps_since_solve( ) << " steps" << endl;
 
-        float zmax = -9999999.99f;
-        for(int n : IntRange( 0, zabove.size( ) ))
+        if(_solve_skipped)
         {
-            zabove[n] = zbelow[n] + nodal_thickness[n];
-            if(zabove[n] > zmax) zmax = zabove[n];
+            _trigger.skipped( );
+            _profiler.count( "solve_skipped", 1.0 );
+            increment_step( );
+            cout << "[run_timestep] step " << _time_step << " not solved, the last results are reused" << endl;
+            return 0;
         }
+        _trigger.solved( );
+    }
+
+    {
+        //only on the steps that are solved: the basement displacement is the one since the last solve
+        ScopedTimer boundary_timer( _profiler, "boundary_conditions" );
+        update_boundary_conditions( top );
+    }
 
+    if(_warm_start)
+    {
+        //old layers from the last results, new layers lithostatic; a cold start when there are no results yet
+        ScopedTimer warm_start_timer( _profiler, "warm_start" );
+        string warm_start_error;
+        if(!WarmStart::prepare( _data_arrays, geometry, transfer( ), old_num_surfaces - 1, warm_start_error ))
+        {
+            if(!warm_start_error.empty( )) cout << warm_start_error << endl;
+            WarmStart::cold( _data_arrays, geometry.total_elements( ) );
+        }
     }
 
+    if(_lumping.enabled( ))
+    {
+        //the solver gets the merged layers; update_results expands the results back to every layer
+        ScopedTimer lumping_timer( _profiler, "lumping" );
+        _lumping.begin( geometry, _data_arrays );
+        _profiler.count( "layers_merged", (double)_lumping.layers_merged( ) );
+    }
 
-    _mech_props_model->update_initial_mech_props( gpm_attributes, _sediments, _visage_options, _data_arrays, old_num_surfaces, new_num_surfaces );
+    if(_remove_pinchouts)
+    {
+        //on the grid the solver gets (merged layers included); update_results fills the results of the inactive cells
+        ScopedTimer active_timer( _profiler, "active_elements" );
+        size_t inactive = ActiveElements::build( geometry, _visage_options->pinchout_tolerance( ), _data_arrays );
+        _profiler.count( "inactive_elements", (double)inactive );
+    }
 
     int nprops = _data_arrays.count( );
-
-    timer = make_shared<ChronoPoint>( "Deck writting" );
+    _profiler.count( "elements", (double)geometry.total_elements( ) );
+    _profiler.count( "bytes_written", (double)solver_payload_bytes( ) );
 
     //update_mech_props( gpm_attributes, old_num_surfaces, new_num_surfaces );
     increment_step( );
-    string mii_file_name = VisageDeckWritter::write_deck( &_visage_options, &_data_arrays, &_to_visage_unit_conversion );
 
-    timer = make_shared<ChronoPoint>( "Visage running" );
-    if(run_visage( mii_file_name ) != 0)
+    if(!_worker_command.empty( ) && !_worker.start( _worker_command, log ))
     {
-        log += ("Visage run failed.  MII file: " + mii_file_name);
-        _error = true;
+        cout << log << "\nFalling back to eclrun" << endl;
+        _worker_command.clear( );
+    }
+
+    if(!_worker_command.empty( ))
+    {
+        //no deck: geometry and arrays go to the worker through shared memory, update_results collects the results
+        ScopedTimer submit_timer( _profiler, "worker_submit" );
+        _budget.solver_started( );
+        if(_worker.submit_step( _time_step, geometry, _data_arrays, &_to_visage_unit_conversion, log )) return 0;
+        if(_worker.running( ))
+        {
+            _error = true;
+            return 1;
+        }
+
+        //the worker died under us: this step (and the next ones) go through eclrun
+        cout << log << "\nSolver worker exited, falling back to eclrun" << endl;
+        _worker_command.clear( );
+    }
+
+    string mii_file_name;
+    {
+        ScopedTimer deck_timer( _profiler, "deck" );
+        mii_file_name = VisageDeckWritter::write_deck( &_visage_options, &_data_arrays, &_to_visage_unit_conversion );
+    }
+
+    if(_async_solver)
+    {
+        //the host keeps going, update_results waits for the solver
+        ScopedTimer launch_timer( _profiler, "solver_launch" );
+        _budget.solver_started( );
+        if(!launch_visage( mii_file_name ))
+        {
+            log += ("Visage could not be launched.  MII file: " + mii_file_name);
+            _error = true;
+        }
+        return _error ? 1 : 0;
+    }
+
+    {
+        ScopedTimer solver_timer( _profiler, "solver" );
+        _budget.solver_started( );
+        if(run_visage( mii_file_name ) != 0)
+        {
+            log += ("Visage run failed.  MII file: " + mii_file_name);
+            _error = true;
+        }
+        _budget.solver_finished( );
     }
-    timer.reset( );
 
     return _error ? 1 : 0;
 }
@@ -280,11 +603,10 @@ bool gpm_visage_link::update_gpm_and_visage_geometris_from_visage_results( map<s
         return false;
     }
 
-    std::vector<float> nodal_values;
     StructuredGrid& geometry = _visage_options->geometry( );
     auto [ncols, nrows, nsurfaces, total_nodes, total_elements] = geometry->get_geometry_description( );
 
-    nodal_values.resize( total_nodes );
+    std::vector<float>& nodal_values = _scratch->get( total_nodes );
     if(_data_arrays.contains( "NRCKDISZ" ))
     {
         std::vector<float>& values = (_data_arrays.get_array( "NRCKDISZ" ));
@@ -293,7 +615,7 @@ bool gpm_visage_link::update_gpm_and_visage_geometris_from_visage_results( map<s
     else if(_data_arrays.contains( "ROCKDISZ" ))
     {
         std::vector<float>& values = (_data_arrays.get_array( "ROCKDISZ" ));
-        nodal_values = StructuredBase::elemental_to_nodal( ncols, nrows, nsurfaces, values );//, values);
+        transfer( ).to_nodes( values, nodal_values );
     }
     else
     {
@@ -312,9 +634,7 @@ bool gpm_visage_link::update_gpm_and_visage_geometris_from_visage_results( map<s
     {
         auto [vs_it1, vs_it2] = geometry.surface_range( k );
 
-        auto [gpm_it1, _] = att_iterator::surface_range( top, k );
-
-        std::copy( vs_it1, vs_it2, gpm_it1 );
+        att_iterator::copy_to_surfaces( vs_it1, top, k, k + 1 );
     }
 
     return true;
@@ -329,55 +649,273 @@ void   gpm_visage_link::update_compacted_props( attr_lookup_type& attributes )
 
 
 
-int   gpm_visage_link::update_results( attr_lookup_type& attributes, std::string& error, int step )
+int   gpm_visage_link::update_results( attr_lookup_type& gpm_attributes, std::string& error, int step )
 {
-    read_visage_results( _time_step, error );
+    if(_restart_step >= 0 && _time_step < _restart_step) return 0;
 
-    update_compacted_props( attributes );
+    //coarsened: results applied to the restricted attributes, then prolonged to gpm's
+    attr_lookup_type& attributes = _coarsening.enabled( ) ? _coarsening.restrict_attributes( gpm_attributes ) : gpm_attributes;
+    if(_coarsening.enabled( )) _coarsening.keep_reference( "TOP" );
 
-    update_gpm_and_visage_geometris_from_visage_results( attributes, error );
+    int ret = 0;
+    if(_restart_step >= 0)
+    {
+        //the restored state stands for the results of this step, the tail below (scratch, profiler) is the same
+        _restart_step = -1;
+        ret = restore_checkpoint( attributes, error ) ? 0 : 1;
+        if(ret == 0) prolong_to_gpm( gpm_attributes );
+    }
+    else
+    {
+        bool solved = !_solve_skipped;
+        ret = collect_and_apply_results( attributes, error );
+        if(ret == 0) prolong_to_gpm( gpm_attributes );
+        if(ret == 0 && _budget.enabled( ))
+            _budget.end_step( _visage_options->geometry( )->total_elements( ), solved, BudgetPlanner::command_np( _solver_command_template ) );
 
-    //now we should copy whatever results we need to copy from vs to gpm for display 
-    bool include_top = false;
-    auto to_copy = list_wanted_attribute_names( include_top );
-    const auto& geometry = _visage_options.geometry( );
-    auto [ncols, nrows, nsurfaces, total_nodes, total_elements] = geometry.get_geometry_description( );
+        if(ret == 0 && _checkpoint_interval > 0 && (_time_step + 1) % _checkpoint_interval == 0)
+        {
+            ScopedTimer checkpoint_timer( _profiler, "checkpoint" );
+            if(!save_checkpoint( error )) cout << error << endl;
+        }
+    }
 
+    //scratch buffers that had to grow this step. Once the model size is steady there should be none
+    size_t model_size = _visage_options->geometry( )->total_elements( );
+    _profiler.count( "scratch_allocations", (double)_scratch->allocations( ) );
+    _profiler.count( "scratch_bytes_allocated", (double)_scratch->allocated_bytes( ) );
+    if(_count_allocations)
+    {
+        cout << "[update_results] step " << _time_step << ": " << _scratch->buffers_in_use( ) << " scratch buffers, "
+            << _scratch->allocations( ) << " grew (" << _scratch->allocated_bytes( ) << " bytes), "
+            << _scratch->capacity_bytes( ) << " bytes held" << endl;
+        if(model_size == _scratch_model_size && _scratch->allocations( ) > 0)
+            cout << "[update_results] WARNING: scratch allocations at constant model size (" << model_size << " elements)" << endl;
+    }
+    _scratch_model_size = model_size;
+    _scratch->reset( );
+
+    if(_profiler.enabled( )) cout << _profiler.step_report( _profiler.step( ) );
+    return ret;
+}
 
-    //copy props to gpm for display 
-    for(const auto& vs_prop : to_copy)
+gpm_visage_link::~gpm_visage_link( )
+{
+    //once: the trace holds the whole run, rewriting it every step would cost O(steps^2)
+    if(_profiler.enabled( ) && !_profile_trace.empty( ) && !_profiler.write_chrome_trace( _profile_trace ))
+        cout << "[gpm_visage_link] cannot write profile trace " << _profile_trace << endl;
+}
+
+int   gpm_visage_link::collect_and_apply_results( attr_lookup_type& attributes, std::string& error )
+{
+    ScopedTimer timer( _profiler, "update_results" );
+
+    if(_solve_skipped)
+    {
+        //nothing was solved: the geometry stays as gpm built it, the results of the last solve are shown
+        ScopedTimer reuse_timer( _profiler, "reuse_results" );
+        reuse_last_results( );
+        _solve_skipped = false;
+    }
+    else
     {
-        vector<float>& values = _data_arrays[vs_prop.name];
-        vector<float>* aux = nullptr;
-        auto to_gpm = att_iterator( attributes[vs_prop.name] );
+        if(_solver.pending( ))
+        {
+            ScopedTimer wait_timer( _profiler, "solver_wait" );
+            if(wait_visage( error ) != 0) return 1;
+            _budget.solver_finished( );
+        }
 
-        if(_data_arrays.array_size( vs_prop.name ) == geometry.total_nodes( ))
+        if(_worker.pending( ))
         {
-            copy( values.begin( ), values.end( ), to_gpm );
+            ScopedTimer wait_timer( _profiler, "worker_wait" );
+            if(!collect_worker_results( error )) return 1;
+            _budget.solver_finished( );
+        }
+        else if(!read_visage_results( _time_step, error ))
+        {
+            _error = true;
+            return 1;
         }
 
-        else if(_data_arrays.array_size( vs_prop.name ) == geometry.total_elements( ))
+        set<string> results = list_required_result_names( );
+        set<string> derived = list_derived_result_names( );
+        results.insert( derived.begin( ), derived.end( ) );
+
+        if(_remove_pinchouts && _data_arrays.contains( ActiveElements::array_name ))
         {
-            vector<float> nodal_values = StructuredBase::elemental_to_nodal( ncols, nrows, nsurfaces, values );
+            //still on the solver grid, as the map
+            ScopedTimer fill_timer( _profiler, "fill_inactive" );
+            auto [ncols, nrows, nsurfaces, total_nodes, total_elements] = _visage_options->geometry( ).get_geometry_description( );
+            const vector<float>& actnum = _data_arrays.get_array( ActiveElements::array_name );
+            size_t filled = 0;
+            for(const string& name : results)
+                if(_data_arrays.contains( name )) filled += ActiveElements::fill( _data_arrays.get_array( name ), actnum, ncols, nrows, nsurfaces );
+            _profiler.count( "values_filled", (double)filled );
+        }
 
-            if( (vs_prop.name.find("STRAIN") != string::npos) || (vs_prop.name.find( "STRN" ) != string::npos))
-            {
-             //cout<<"Scaling strains by 1E5"<<endl;
-             //times 1e5
-             for_each( begin(nodal_values), end(nodal_values), []( float &v){v*=1.0e5;} );
-            }
-            if(vs_prop.name.find( "EFFSTR" ) != string::npos) 
-            {
-                //cout << "Scaling effective stress by 1E5" << endl;
-                //times 1e5
-                for_each( begin( nodal_values ), end( nodal_values ), []( float& v ) {v *= 1.0e5; } );
-            }
+        if(_lumping.active( ))
+        {
+            //the map goes back to every layer with the results
+            if(_remove_pinchouts) results.insert( ActiveElements::array_name );
+            ScopedTimer lumping_timer( _profiler, "unlumping" );
+            _lumping.end( _visage_options->geometry( ), _data_arrays, results );
+        }
 
-            copy( nodal_values.begin( ), nodal_values.end( ), to_gpm );
+        {
+            ScopedTimer props_timer( _profiler, "property_update" );
+            update_compacted_props( attributes );
+        }
+
+        {
+            ScopedTimer geometry_timer( _profiler, "geometry" );
+            update_gpm_and_visage_geometris_from_visage_results( attributes, error );
         }
-        else { continue; } //empty values, not computed, etc...etc...       
     }
 
+    ScopedTimer write_back_timer( _profiler, "write_back" );
+
+    //now we should copy whatever results we need to copy from vs to gpm for display 
+    bool include_top = false;
+    vector<string> to_copy;
+    for(const auto& vs_prop : list_wanted_attribute_names( include_top )) to_copy.push_back( vs_prop.name );
+
+    //copy props to gpm for display: averaged to nodes, scaled and written per surface in one pass
+    _write_back.set_outputs( to_copy );
+    _profiler.count( "outputs_written", _write_back.write( _data_arrays, transfer( ), attributes, error ) );
 
     return 0;
-}
\ No newline at end of file
+}
+
+void gpm_visage_link::prolong_to_gpm( attr_lookup_type& gpm_attributes )
+{
+    if(!_coarsening.enabled( )) return;
+
+    //TOP as a change, so that gpm keeps its detail below the visage resolution
+    ScopedTimer timer( _profiler, "prolong" );
+    _coarsening.prolong_change( "TOP", gpm_attributes );
+    _coarsening.prolong_attributes( _coarsening.attributes( ), gpm_attributes, _write_back.outputs( ) );
+}
+
+void gpm_visage_link::reuse_last_results( )
+{
+    StructuredGrid& geometry = _visage_options->geometry( );
+    auto [ncols, nrows, nsurfaces, total_nodes, total_elements] = geometry.get_geometry_description( );
+    const size_t nxy = (size_t)ncols * nrows, exy = (size_t)(ncols - 1) * (nrows - 1);
+
+    //result arrays are one surface (or layer) short for every surface added since the last solve
+    int extended = 0;
+    for(const string& name : _data_arrays.array_names( ))
+    {
+        vector<float>& values = _data_arrays.get_array( name );
+        if(CouplingTrigger::extend_layers( values, exy, total_elements ) || CouplingTrigger::extend_layers( values, nxy, total_nodes ))
+            extended += 1;
+    }
+    _profiler.count( "arrays_extended", (double)extended );
+}
+
+bool gpm_visage_link::save_checkpoint( string& error )
+{
+    StructuredGrid& geometry = _visage_options->geometry( );
+    auto [ncols, nrows, nsurfaces, total_nodes, total_elements] = geometry.get_geometry_description( );
+
+    CouplerCheckpoint::header_type header;
+    header.step = _time_step;
+    header.time = gpm_time.end;
+    header.ui_hash = _ui_hash;
+    header.ncols = ncols;
+    header.nrows = nrows;
+    header.nsurfaces = nsurfaces;
+
+    //geometry: heights and local depths of every surface
+    vector<float>& heights = _scratch->get( 0 );
+    vector<float>& depths = _scratch->get( 0 );
+    heights.clear( );
+    depths.clear( );
+    for(int k = 0; k < nsurfaces; k++)
+    {
+        auto [it1, it2] = geometry.surface_range( k );
+        heights.insert( heights.end( ), it1, it2 );
+        const vector<float>& z = geometry->get_local_depths( k );
+        depths.insert( depths.end( ), z.begin( ), z.end( ) );
+    }
+
+    vector<pair<string, const vector<float>*>> blocks = { { CouplerCheckpoint::heights_block, &heights }, { CouplerCheckpoint::depths_block, &depths } };
+    if(base) blocks.push_back( { CouplerCheckpoint::base_block, &base->heights( ) } );
+    if(prev_base) blocks.push_back( { CouplerCheckpoint::prev_base_block, &prev_base->heights( ) } );
+    for(const string& name : _data_arrays.array_names( )) blocks.push_back( { name, &_data_arrays.get_array( name ) } );
+
+    if(!CouplerCheckpoint::write( _checkpoint_file, header, blocks, error )) return false;
+
+    size_t bytes = 0;
+    for(const auto& block : blocks) bytes += sizeof( float ) * block.second->size( );
+    _profiler.count( "checkpoint_bytes", (double)bytes );
+    cout << "[save_checkpoint] step " << _time_step << " -> " << _checkpoint_file << endl;
+    return true;
+}
+
+bool gpm_visage_link::restore_checkpoint( attr_lookup_type& attributes, string& error )
+{
+    CouplerCheckpoint checkpoint;
+    if(!CouplerCheckpoint::read( _restart_file, checkpoint, error )) return false;
+
+    const auto& header = checkpoint.header;
+    auto& blocks = checkpoint.blocks;
+    const size_t nxy = (size_t)header.ncols * header.nrows;
+    if(attributes.find( "TOP" ) == attributes.end( ) || (int)attributes.at( "TOP" ).size( ) != header.nsurfaces
+        || blocks[CouplerCheckpoint::heights_block].size( ) != nxy * header.nsurfaces)
+    {
+        error += "\n[restore_checkpoint] the model replayed by gpm does not match the checkpoint of step " + to_string( header.step );
+        _error = true;
+        return false;
+    }
+
+    //geometry
+    StructuredGrid& geometry = _visage_options->geometry( );
+    geometry->set_num_surfaces( header.nsurfaces );
+    const vector<float>& heights = blocks[CouplerCheckpoint::heights_block];
+    const vector<float>& depths = blocks[CouplerCheckpoint::depths_block];
+    for(int k = 0; k < header.nsurfaces; k++)
+    {
+        copy( heights.begin( ) + k * nxy, heights.begin( ) + (k + 1) * nxy, geometry->begin_surface( k ) );
+        if(depths.size( ) == heights.size( ))
+        {
+            vector<float>& z = geometry->get_local_depths( k );
+            copy( depths.begin( ) + k * nxy, depths.begin( ) + (k + 1) * nxy, z.begin( ) );
+        }
+    }
+
+    //basement surfaces of the boundary conditions
+    auto restore_surface = [&]( const string& block, std::shared_ptr<StructuredSurface>& surface )
+    {
+        surface.reset( );
+        if(blocks.find( block ) == blocks.end( )) return;
+        surface.reset( new StructuredSurface( geometry->get_structured_surface( 0 ) ) );
+        surface->heights( ).swap( blocks[block] );
+    };
+    restore_surface( CouplerCheckpoint::base_block, base );
+    restore_surface( CouplerCheckpoint::prev_base_block, prev_base );
+
+    //data arrays
+    for(auto& [name, values] : blocks)
+        if(name[0] != '#') _data_arrays.get_or_create_array( name ).swap( values );
+
+    _time_step = header.step;
+    _visage_options->update_step( _time_step );
+    cout << "[restore_checkpoint] restored step " << header.step << " (gpm time " << header.time << ") from " << _restart_file << endl;
+
+    //gpm gets the coupled geometry and the display arrays of that step
+    gpm_attribute& top = attributes.at( "TOP" );
+    for(int k : IntRange( 1, header.nsurfaces ))
+    {
+        auto [vs_it1, vs_it2] = geometry.surface_range( k );
+        att_iterator::copy_to_surfaces( vs_it1, top, k, k + 1 );
+    }
+
+    vector<string> to_copy;
+    for(const auto& vs_prop : list_wanted_attribute_names( false )) to_copy.push_back( vs_prop.name );
+    _write_back.set_outputs( to_copy );
+    _write_back.write( _data_arrays, transfer( ), attributes, error );
+
+    return true;
+}
@@ -40,32 +40,24 @@ namespace fs = std::experimental::filesystem;
 #include "IMechPropertyModel.h"
 #include "MechProperyModel.h"
 #include "gpm_visage_results.h"
+#include "gpm_visage_solver_process.h"
+#include "gpm_visage_worker_backend.h"
+#include "gpm_visage_profiler.h"
+#include "GridTransfer.h"
+#include "gpm_visage_derived_results.h"
+#include "ScratchPool.h"
+#include "gpm_visage_write_back.h"
+#include "gpm_visage_checkpoint.h"
+#include "gpm_visage_warm_start.h"
+#include "gpm_visage_coupling_trigger.h"
+#include "gpm_visage_budget_planner.h"
+#include "gpm_visage_coarsening.h"
+#include "gpm_visage_layer_lumping.h"
+#include "gpm_visage_active_elements.h"
 
 
 
 using namespace std;
-class ChronoPoint
-{
-public:
-
-    ChronoPoint( string s = " " )
-    {
-        name = s;
-        start = std::chrono::system_clock::now( );
-    }
-
-    ~ChronoPoint( )
-    {
-        std::chrono::system_clock::time_point end = std::chrono::system_clock::now( );
-        std::cout << "********Elapsed time " << name
-            << " (ms): " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count( )
-            << " (us): " << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count( )
-            << endl;
-    }
-
-    string name; std::chrono::system_clock::time_point start;
-};
-
 
 class gpm_visage_link
 {
@@ -96,17 +88,93 @@ class gpm_visage_link
     //float _lateral_strain;
     int _time_step;
 
+    //async: run_timestep launches the solver and returns, update_results waits for it (up to _solver_timeout seconds, < 0 no limit)
+    bool _async_solver;
+    double _solver_timeout;
+    VisageSolverProcess _solver;
+
+    //solver command line, with {mii} {xfile} {snapshot} placeholders (e.g. "visage_emulator {snapshot} {xfile}" for offline runs)
+    string _solver_command_template;
+
+    //worker mode: a persistent solver process fed through shared memory instead of deck + eclrun (empty command: off)
+    string _worker_command;
+    VisageWorkerBackend _worker;
+
+    //EQPLSTRAIN and other results computed from the solver arrays, on demand
+    DerivedResults _derived;
+
+    //node <-> element averaging of the current geometry, see transfer( )
+    GridTransfer _transfer;
+
+    //display arrays back to gpm at the end of update_results
+    WriteBackPlan _write_back;
+
+    //scoped timers and counters per step (on unless "profile": false), dumped to _profile_trace at the end of the run if set
+    Profiler _profiler;
+    string _profile_trace;
+
+    //per-step scratch buffers, shared with the property model and reset at the end of update_results.
+    //"count_allocations": report the buffers that still grow once the model size is steady
+    shared_ptr<ScratchPool> _scratch;
+    bool _count_allocations;
+    size_t _scratch_model_size;
+
+    //the state after every _checkpoint_interval steps goes to _checkpoint_file ("CheckpointInterval", "CheckpointFile").
+    //"RestartFrom": the steps the host replays up to the step of that checkpoint are skipped, and the state is
+    //restored in update_results of that step. Refused if the sediments or tables differ from the checkpoint's (_ui_hash)
+    string _checkpoint_file, _restart_file;
+    int _checkpoint_interval;
+    int _restart_step;
+    uint64_t _ui_hash;
+
+    //"warm_start": the solver starts from the stresses of the last step (see WarmStart)
+    bool _warm_start;
+
+    //solve only when the load changed enough ("TriggerThickness", "TriggerLoad", "TriggerMaxInterval").
+    //_solve_skipped: this step reuses the last results
+    CouplingTrigger _trigger;
+    bool _solve_skipped;
+
+    //eta of the run ("RunEndTime") and, with "BudgetHours", the --np and coupling interval that keep it in budget
+    BudgetPlanner _budget;
+
+    //"LateralCoarsening": visage runs on a grid that many times coarser laterally than gpm's (1: same grid)
+    LateralCoarsening _coarsening;
+    int _coarsening_factor;
+
+    //"LumpThickness", "LumpKeepTop": old thin layers merged for the solve, from run_timestep to the results read in update_results
+    LayerLumping _lumping;
+
+    //"remove_pinchouts": elements thinner than the pinchout tolerance are inactive (ACTNUM) in the solve, their results filled from the neighbours
+    bool _remove_pinchouts;
+
 public:
 
     gpm_visage_link( shared_ptr<IConfiguration>& config, shared_ptr<IMechanicalPropertiesInitializer> props_model )
     {
         _config = config;
         _mech_props_model = props_model;
+        _scratch = make_shared<ScratchPool>( );
+        _mech_props_model->use_scratch( _scratch );
+        _trigger.use_scratch( _scratch );
+        _worker.use_scratch( _scratch );
+        _count_allocations = false;
+        _scratch_model_size = 0;
+        _checkpoint_interval = 0;
+        _restart_step = -1;
+        _ui_hash = 0;
+        _warm_start = false;
+        _solve_skipped = false;
+        _coarsening_factor = 1;
+        _remove_pinchouts = false;
 
         _config->initialize_vs_options( _visage_options );
         _gpm_vs_name_map["POR"] = "POROSITY"; //this means "POR" in gpm and "POROSITY" in visage.
         _time_step = -1;
         _error = false;
+        _async_solver = false;
+        _solver_timeout = -1.0;
+        _solver_command_template = "eclrun visage  {mii} --np=4";
 
         //stress in X files is in KPa and YM in GPa. We will use MPa for the stress and GPa for YM 
         //cohesion, tensile strength will also be in MPa
@@ -123,6 +191,7 @@ public:
          {"TENSILE_STRENGTH", 1000.00f}, //all the program is in MPa ->passed as KPa to vs
          {"DENSITY", 10.00f} //all the program is in gr/cm3 ->passed as KPa rho * g 
         };
+        for(const auto& names : WarmStart::stress_names( )) _to_visage_unit_conversion[names.second] = 1000.0f; //MPa -> KPa
 
 
 
@@ -133,6 +202,9 @@ public:
 
     }
 
+    //end of the run: writes the profile trace
+    ~gpm_visage_link( );
+
     gpm_visage_link* operator->( ) { return this; }
 
     void update_compacted_props( attr_lookup_type& attributes );
@@ -160,15 +232,44 @@ public:
 
     void initialize_model_extents( const gpm_plugin_api_model_definition* model_def )
     {
-        _config->initialize_model_extents( _visage_options, model_def );
+        //same extent, fewer nodes when coarsened
+        _coarsening.setup( (int)model_def->num_columns, (int)model_def->num_rows, _coarsening_factor );
+        gpm_plugin_api_model_definition visage_def = *model_def;
+        if(_coarsening.enabled( ))
+        {
+            visage_def.num_columns = _coarsening.ncols( );
+            visage_def.num_rows = _coarsening.nrows( );
+        }
+        _config->initialize_model_extents( _visage_options, &visage_def );
     }
 
     vector<pair<string, bool>> list_needed_attribute_names( const vector<string>& all_atts ) const;
 
     vector<gpm_visage_link::property_type> list_wanted_attribute_names( bool include_top = true ) const;
 
+    //the arrays read back from the X files: what we display, what the property models use and the displacements for the geometry
+    set<string> list_required_result_names( ) const;
+
+    //the derived results (see DerivedResults) someone asked for this run
+    set<string> list_derived_result_names( ) const;
+
     int  update_results( attr_lookup_type& attributes, std::string& error, int step = -1 );
 
+    //the body of update_results: reads the step results, updates props and geometry, writes back to gpm
+    int  collect_and_apply_results( attr_lookup_type& attributes, std::string& error );
+
+    //see _checkpoint_file
+    bool save_checkpoint( string& error );
+
+    //a step that was not solved: the last results, extended over the new layers
+    void reuse_last_results( );
+
+    //replaces geometry, basement surfaces and data arrays with the checkpoint, then writes them back to gpm
+    bool restore_checkpoint( attr_lookup_type& attributes, string& error );
+
+    //coarsened runs: TOP changes and display arrays of the coarse attributes back to the gpm ones
+    void prolong_to_gpm( attr_lookup_type& gpm_attributes );
+
 
     bool update_gpm_and_visage_geometris_from_visage_results( map<string, gpm_attribute>& attributes, string& error );
 
@@ -176,26 +277,40 @@ public:
 
     vector<float> get_values( const gpm_attribute& att, int k1 = 0, int k2 = -1 )
     {
-        vector<float> nodal_values;
-        for(int k : IntRange( k1, k2 ))
-        {
-            auto [it1, it2] = const_att_iterator::surface_range( att, k );
-            std::copy( it1, it2, back_inserter( nodal_values ) );
-        }
+        vector<float> nodal_values( k2 > k1 ? (k2 - k1) * att[0].num_cols( ) * att[0].num_rows( ) : 0 );
+        const_att_iterator::copy_surfaces( att, k1, k2, nodal_values.begin( ) );
         return nodal_values;
     }
 
     vector<float> get_gpm_heights( const gpm_attribute& att, int k1 = 0 )
     {
-        vector<float> nodal_values;
-        auto [it1, it2] = const_att_iterator::surface_range( att, k1 );
-        std::copy( it1, it2, back_inserter( nodal_values ) );
+        return get_values( att, k1, k1 + 1 );
+    }
+
+    //same, into a caller buffer
+    vector<float>& get_values( const gpm_attribute& att, int k1, int k2, vector<float>& nodal_values )
+    {
+        nodal_values.resize( k2 > k1 ? (k2 - k1) * att[0].num_cols( ) * att[0].num_rows( ) : 0 );
+        const_att_iterator::copy_surfaces( att, k1, k2, nodal_values.begin( ) );
         return nodal_values;
     }
 
 
     bool  gpm_visage_link::read_visage_results( int last_step, string& error );
 
+    bool  collect_worker_results( string& error );
+
+    //results computed from others, after every read
+    void  compute_derived_results( );
+
+    //geometry and arrays handed to the solver every step (bytes, before the deck formatting)
+    size_t solver_payload_bytes( )
+    {
+        size_t bytes = sizeof( float ) * geometry( ).total_nodes( );
+        for(const string& name : _data_arrays.array_names( )) bytes += sizeof( float ) * _data_arrays.array_size( name );
+        return bytes;
+    }
+
     std::tuple<int, int, int, int> node_values_count( const gpm_attribute& p, int  k = 0 ) const
     {
         const auto& geo = p.at( k );
@@ -227,8 +342,23 @@ public:
 
     StructuredGrid& geometry( ) { return _visage_options->geometry( ); }
 
+    //the cached operator follows the geometry (surfaces appended every step)
+    const GridTransfer& transfer( )
+    {
+        auto [ncols, nrows, nsurfaces, total_nodes, total_elements] = geometry( ).get_geometry_description( );
+        _transfer.reset( ncols, nrows, nsurfaces );
+        return _transfer;
+    }
+
     int  run_visage( string mii_file );
 
+    //expands _solver_command_template; {snapshot} also writes the model snapshot next to the deck
+    string solver_command( string mii_file );
+
+    bool launch_visage( string mii_file );
+
+    int  wait_visage( string& error );
+
     bool _error;
 
 
@@ -239,7 +369,7 @@ private:
         //debug
 
         auto [ncols, nrows, nsurfaces, total_nodes, total_elements] = _visage_options->geometry( )->get_geometry_description( );
-        std::vector<float> nodal_values;
+        std::vector<float>& nodal_values = _scratch->get( total_nodes );
         {
             if(!_data_arrays.contains( name ))
             {
@@ -248,12 +378,11 @@ private:
             }
 
             vector<float>& values = _data_arrays.get_array( name );
-            nodal_values.resize( total_nodes );
 
             if(values.size( ) == total_elements)
             {
                 //We need to pass them to gpm as nodal properties.
-                nodal_values = StructuredGrid::elemental_to_nodal( ncols, nrows, nsurfaces, values );//, values);
+                transfer( ).to_nodes( values, nodal_values );
             }
             else if(values.size( ) == total_nodes) //inneficient !!
             {
@@ -261,7 +390,7 @@ private:
             }
             else if(values.size( ) == 1) //constant !!
             {
-                nodal_values.resize( total_nodes, values[0] );
+                fill( begin( nodal_values ), end( nodal_values ), values[0] );
             }
 
             else
@@ -271,20 +400,7 @@ private:
             }
         }
 
-        int counter = 0, offset = 0;
-        for(int surface = 0; surface < nsurfaces; surface++)
-        {
-            auto& my_array_holder = prop.at( surface );
-            for(int j = 0; j < nrows; j++)
-            {
-                for(int i = 0; i < ncols; i++)
-                {
-                    //prop[surface](j, i) = nodal_values[offset + counter];
-                    my_array_holder( j, i ) = nodal_values[offset + counter];
-                    counter += 1;
-                }
-            }
-        }
+        att_iterator::copy_to_surfaces( nodal_values.cbegin( ), prop, 0, nsurfaces );
 
         return true;
     }
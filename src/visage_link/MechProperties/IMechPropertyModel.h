@@ -8,6 +8,10 @@
 #include "AttributeIterator.h"
 #include "Definitions.h"
 #include "UIParamerers.h"
+#include "SedimentPropertyMixer.h"
+#include "GridTransfer.h"
+#include "ArrayStore.h"
+#include "ScratchPool.h"
 
 using namespace std;
 
@@ -20,27 +24,66 @@ protected:
 
 public:
 
+    IMechanicalPropertiesInitializer( )
+    {
+        _strain_xx = _arrays.intern( "STRAINXX" );
+        _strain_yy = _arrays.intern( "STRAINYY" );
+        _strain_zz = _arrays.intern( "STRAINZZ" );
+        _porosity = _arrays.intern( WellKnownVisageNames::ResultsArrayNames::Porosity );
+        _init_porosity = _arrays.intern( "Init" + WellKnownVisageNames::ResultsArrayNames::Porosity );
+        _stiffness = _arrays.intern( WellKnownVisageNames::ResultsArrayNames::Stiffness );
+        _init_stiffness = _arrays.intern( "Init" + WellKnownVisageNames::ResultsArrayNames::Stiffness );
+        _eq_plastic_strain = _arrays.intern( "EQPLSTRAIN" );
+    }
+
+    //the sediment keys (SED1,SED2,...SEDN) of the ui, interned once
+    void intern_arrays( const vector<string>& sediment_keys )
+    {
+        for(const string& key : sediment_keys) _arrays.intern_sediment( key );
+    }
+
+    //the per-step scratch buffers (the owner resets them at the end of the step)
+    void use_scratch( shared_ptr<ScratchPool> pool ) { _scratch = pool; }
+
     virtual vector<float> get_values( const gpm_attribute& att, int k1 = 0, int k2 = -1 )
     {
         vector<float> nodal_values;
-        for(int k : IntRange( k1, k2 ))
-        {
-            auto[it1, it2] = const_att_iterator::surface_range( att, k );
-            std::copy( it1, it2, back_inserter( nodal_values ) );
-        }
+        return get_values( att, k1, k2, nodal_values );
+    }
+
+    //same, into a caller buffer
+    vector<float>& get_values( const gpm_attribute& att, int k1, int k2, vector<float>& nodal_values )
+    {
+        nodal_values.resize( k2 > k1 ? (k2 - k1) * att[0].num_cols( ) * att[0].num_rows( ) : 0 );
+        const_att_iterator::copy_surfaces( att, k1, k2, nodal_values.begin( ) );
         return nodal_values;
     }
 
+    //results the model reads back from the geomechanics run (see update_porosity)
+    virtual set<string> required_result_names( ) const
+    {
+        return { "STRAINXX", "STRAINYY", "STRAINZZ" };
+    }
+
+    //derived results (see DerivedResults) the model reads in update_compacted_props. The argument is true for an
+    //elastic run, where the plastic strain based ones (EQPLSTRAIN) are not needed; this model reads none
+    virtual set<string> derived_result_names( bool ) const
+    {
+        return {};
+    }
+
     //based on total strain
     virtual void update_porosity( const attr_lookup_type& atts, map<string, SedimentDescription>& sediments, VisageDeckSimulationOptions& options, ArrayData& data_arrays )
     {
+        bind_arrays( atts, data_arrays );
+
         //the total volumetric strain: assume it is cummulative.
-        vector<float>& exx = data_arrays.get_array( "STRAINXX" );
-        vector<float>& eyy = data_arrays.get_array( "STRAINYY" );
-        vector<float>& ezz = data_arrays.get_array( "STRAINZZ" );
+        vector<float>& exx = _arrays[_strain_xx];
+        vector<float>& eyy = _arrays[_strain_yy];
+        vector<float>& ezz = _arrays[_strain_zz];
 
-        const vector<float>& initPoro = data_arrays.get_array( "Init" + WellKnownVisageNames::ResultsArrayNames::Porosity );
-        vector<float>& poro = data_arrays.get_array( WellKnownVisageNames::ResultsArrayNames::Porosity );
+        const vector<float>& initPoro = _arrays[_init_porosity];
+        vector<float>& poro = _arrays[_porosity];
 
         ////option 1: apparently the correct one
         for(auto n : IntRange( 0, ezz.size( ) ))
@@ -63,19 +106,106 @@ public:
     {
         if(old_nsurf == new_nsurf) return;
 
-        vector<string> sed_keys = {}; //SED1,SED2,...SEDN  
-        for_each( cbegin( atts ), cend( atts ), [&sed_keys, key = "SED"]( const auto& att )
+        bind_arrays( atts, data_arrays );
+        const vector<string>& sed_keys = _sediment_keys; //SED1,SED2,...SEDN  
+
+        auto [vs_cols, vs_rows, vs_surfaces, vs_total_nodes, vs_total_elements] = options->geometry( ).get_geometry_description( );
+        int offset = (vs_cols - 1) * (vs_rows - 1) * (old_nsurf > 0 ? (old_nsurf - 1) : 0);
+
+        if(_incremental_update)
+        {
+            update_new_layers_mech_props( atts, sediments, options, data_arrays, sed_keys, old_nsurf, new_nsurf );
+        }
+        else
+        {
+            recompute_all_mech_props( atts, sediments, options, data_arrays, sed_keys, old_nsurf, new_nsurf );
+        }
+
+        //we need to keep a copy of the intial stiffness and porosity, this lambda will create them
+        auto make_initial = [this, offset]( ArrayStore::handle initial_handle, ArrayStore::handle values_handle )
+        {
+            auto& intitial = _arrays[initial_handle];
+            auto& values   = _arrays[values_handle];
+            intitial.resize( values.size( ) );
+            copy( begin( values ) + offset, end( values ), begin( intitial ) + offset );
+        };
+
+        make_initial( _init_stiffness, _stiffness );
+        make_initial( _init_porosity, _porosity );
+
+
+        //auto &intitial_stiffness = data_arrays[ "Init" + WellKnownVisageNames::ResultsArrayNames::Stiffness ];
+        //auto& stiffness = data_arrays[WellKnownVisageNames::ResultsArrayNames::Stiffness];
+        //intitial_stiffness.resize( stiffness.size() );
+        //copy( begin(stiffness) + offset, end(stiffness), begin( intitial_stiffness ) + offset );
+        //and also a copy of the intial porosity 
+
+
+    }
+
+    //true: only the surfaces of the new layers are read and mixed every step. false: the whole column is recomputed
+    bool& incremental_update( ) { return _incremental_update; }
+
+    virtual void update_compacted_props( const attr_lookup_type& atts, map<string, SedimentDescription> &sediments, VisageDeckSimulationOptions &options, ArrayData &data_arrays, const Table& plastic_multiplier ) = 0;
+
+    ~IMechanicalPropertiesInitializer( ) {}
+
+protected:
+
+    //reads, mixes and converts only surfaces [old_nsurf-1, new_nsurf), i.e. the top of the old column and the new layers.
+    //Elements below are never touched again, so the element arrays are updated in place from offset on.
+    void update_new_layers_mech_props( const attr_lookup_type& atts, const map<string, SedimentDescription>& sediments, VisageDeckSimulationOptions& options, ArrayData& data_arrays, const vector<string>& sed_keys, int old_nsurf, int new_nsurf )
+    {
+        auto [vs_cols, vs_rows, vs_surfaces, vs_total_nodes, vs_total_elements] = options->geometry( ).get_geometry_description( );
+        int first_surface = old_nsurf > 0 ? (old_nsurf - 1) : 0;
+        int nxy = vs_cols * vs_rows;
+        int slab_surfaces = new_nsurf - first_surface;
+        int offset = (vs_cols - 1) * (vs_rows - 1) * first_surface;
+
+        if(!_mixer.matches( sed_keys ))
+        {
+            _mixer = SedimentPropertyMixer( sediments, sed_keys );
+            _mixer_properties.clear( );
+            for(const string& prop : _mixer.property_names( )) _mixer_properties.push_back( _arrays.intern( prop ) );
+        }
+
+        vector<const float*> fractions;
+        for(size_t s = 0; s < sed_keys.size( ); s++)
+        {
+            //the nodal sediment arrays are kept for the compaction models. Only their top part changes,
+            //and it is read straight into them
+            auto& sed_array = _arrays[_sediment_handles[s]];
+            sed_array.resize( new_nsurf * nxy, 0.0f );
+            const_att_iterator::copy_surfaces( atts.at( sed_keys[s] ), first_surface, new_nsurf, sed_array.begin( ) + first_surface * nxy );
+            fractions.push_back( sed_array.data( ) + first_surface * nxy );
+        }
+
+        //all the sediment-related properties (POROSITY, YOUNGMOD, DENSITY,...) in one pass, straight into the element arrays
+        for(ArrayStore::handle prop : _mixer_properties)
         {
-        if(att.first.find( key ) != std::string::npos) sed_keys.push_back( att.first ); 
-        });
+            auto& data_array = _arrays[prop];
+            if(data_array.size( ) != vs_total_elements)
+            {
+                data_array.resize( vs_total_elements, 0.0f ); //initial sediment-related property
+            }
+        }
+
+        vector<float*> elemental;
+        for(ArrayStore::handle prop : _mixer_properties) elemental.push_back( _arrays[prop].data( ) + offset );
+
+        _mixer.mix_to_elements( vs_cols, vs_rows, slab_surfaces, fractions, elemental );
+    }
 
-         
+    //reference path: re-extracts the whole column from surface 0 and converts the full volume.
+    void recompute_all_mech_props( const attr_lookup_type& atts, const map<string, SedimentDescription>& sediments, VisageDeckSimulationOptions& options, ArrayData& data_arrays, const vector<string>& sed_keys, int old_nsurf, int new_nsurf )
+    {
         set<string> prop_names = { sediments.at( sed_keys[0] ).property_names( ) }; //"POROSITY", "YOUNGMOD",......etc...")
         auto [vs_cols, vs_rows, vs_surfaces, vs_total_nodes, vs_total_elements] = options->geometry( ).get_geometry_description( );
         int offset = (vs_cols - 1) * (vs_rows - 1) * (old_nsurf > 0 ? (old_nsurf - 1) : 0);
 
         int tot_nodes = (atts.at( "TOP" ).size( ) * atts.at( "TOP" )[0].num_cols( ) * atts.at( "TOP" )[0].num_rows( ));
-        vector<float> value( tot_nodes );
+        vector<float>& value = _scratch->get( tot_nodes );
+        vector<float>& weights = _scratch->get( tot_nodes );
 
 
         for(string prop : prop_names)  // for each sediment-related property: POROSITY, STIFFNESS, etc...
@@ -83,11 +213,12 @@ public:
 
             //get the weighted volume average 
             fill( value.begin( ), value.end( ), 0.0f );
-            for(string key : sed_keys)
+            for(size_t s = 0; s < sed_keys.size( ); s++)
             {
-                vector<float> weights = get_values( atts.at( key ), 0, new_nsurf );
+                const string& key = sed_keys[s];
+                get_values( atts.at( key ), 0, new_nsurf, weights );
 
-                data_arrays.set_array( key, weights );
+                _arrays[_sediment_handles[s]] = weights;
 
                 transform( begin( weights ), end( weights ), begin( weights ), [val = sediments.at( key ).properties.at( prop )]( float& v ){ return v * val; } );
                 for(int n = 0; n < tot_nodes; n++)
@@ -97,41 +228,65 @@ public:
             }
 
             //value is the sediment-volume-weighted average of property = prop (nodal in gpm) porosity, stiffness,etc. whatever in the outer loop
-            auto& data_array = data_arrays[prop];
-            vector<float> ele_values = options->geometry( ).nodal_to_elemental( value );
+            auto& data_array = _arrays[_arrays.intern( prop )];
             if(data_array.size( ) != vs_total_elements)
             {
                 data_array.resize( vs_total_elements, 0.0f ); //initial sediment-related property
             }
+            //the whole grid through StructuredGrid, independent of the GridTransfer kernels the incremental path uses
+            vector<float> ele_values = options->geometry( ).nodal_to_elemental( value );
             copy( ele_values.begin( ) + offset, ele_values.end( ), data_array.begin( ) + offset );
         }
+    }
 
+    //resolves the interned arrays in data_arrays, once per call of the model. The sediments of the step are the
+    //interned ones that gpm has as attributes (if the ui gave none, the SED attributes are interned the first time)
+    void bind_arrays( const attr_lookup_type& atts, ArrayData& data_arrays )
+    {
+        if(_arrays.sediments( ).empty( ))
+        {
+            for(const auto& att : atts)
+                if(att.first.find( "SED" ) != std::string::npos) _arrays.intern_sediment( att.first );
+        }
 
-        //we need to keep a copy of the intial stiffness and porosity, this lambda will create them
-        auto make_initial = [&data_arrays, offset](string variable_name)
+        _arrays.bind( data_arrays );
+
+        if(_arrays.sediments( ).size( ) != _sediments_filtered)
         {
-            auto& intitial = data_arrays["Init" + variable_name];
-            auto& values   = data_arrays[variable_name];
-            intitial.resize( values.size( ) );
-            copy( begin( values ) + offset, end( values ), begin( intitial ) + offset );
-        };
+            _sediments_filtered = _arrays.sediments( ).size( );
+            _sediment_handles.clear( );
+            for(ArrayStore::handle s : _arrays.sediments( ))
+                if(atts.find( _arrays.name( s ) ) != atts.end( )) _sediment_handles.push_back( s );
+            _sediment_keys = _arrays.names( _sediment_handles );
+        }
+    }
 
-        make_initial( WellKnownVisageNames::ResultsArrayNames::Stiffness  );
-        make_initial( WellKnownVisageNames::ResultsArrayNames::Porosity );
+    //node <-> element operator of the current geometry
+    const GridTransfer& transfer( VisageDeckSimulationOptions& options )
+    {
+        auto [ncols, nrows, nsurfaces, total_nodes, total_elements] = options->geometry( ).get_geometry_description( );
+        _transfer.reset( ncols, nrows, nsurfaces );
+        return _transfer;
+    }
 
+    bool _incremental_update = true;
 
-        //auto &intitial_stiffness = data_arrays[ "Init" + WellKnownVisageNames::ResultsArrayNames::Stiffness ];
-        //auto& stiffness = data_arrays[WellKnownVisageNames::ResultsArrayNames::Stiffness];
-        //intitial_stiffness.resize( stiffness.size() );
-        //copy( begin(stiffness) + offset, end(stiffness), begin( intitial_stiffness ) + offset );
-        //and also a copy of the intial porosity 
+    SedimentPropertyMixer _mixer;
 
+    GridTransfer _transfer;
 
-    }
+    vector<float> _elemental_buffer; //scratch for per-sediment element averages
 
-    virtual void update_compacted_props( const attr_lookup_type& atts, map<string, SedimentDescription> &sediments, VisageDeckSimulationOptions &options, ArrayData &data_arrays, const Table& plastic_multiplier ) = 0;
+    shared_ptr<ScratchPool> _scratch = make_shared<ScratchPool>( );
 
-    ~IMechanicalPropertiesInitializer( ) {}
+    ArrayStore _arrays;
+    ArrayStore::handle _strain_xx, _strain_yy, _strain_zz, _porosity, _init_porosity, _stiffness, _init_stiffness, _eq_plastic_strain;
+    vector<ArrayStore::handle> _mixer_properties; //the arrays of _mixer.property_names( )
+
+    //the sediments gpm has as attributes: handles and keys in the same order
+    vector<ArrayStore::handle> _sediment_handles;
+    vector<string> _sediment_keys;
+    size_t _sediments_filtered = 0; //number of interned sediments when the two above were built
 
 
 };
@@ -12,6 +12,7 @@
 #include "Definitions.h"
 #include "UIParamerers.h"
 #include "IMechPropertyModel.h"
+#include "TableEvaluator.h"
 
 using namespace std;
 
@@ -44,40 +45,41 @@ public:
 
         //each element will have a field "dvt_table_index", which will be 0,1,2,3....
         //depending on whether SED0, SED1,....is the most predominant component.
-        vector<string> tmp = data_arrays.array_names( );
-        vector<string> sed_keys;//find gpm_names SED1,SED2,...SEDN
-        for_each( cbegin( tmp ), cend( tmp ), [&sed_keys, key = "SED"]( const auto& name )
-        {if(name.find( key ) != std::string::npos) sed_keys.push_back( name ); } );
-
-        //here sed_keys is SED1, SED2,....SEDN and those keys match sediments.at( sed_name ) and each
+        //sed_keys are the SED1, SED2,....SEDN arrays, those keys match sediments.at( sed_name ) and each
         //hast its own compaction table.
+        const vector<ArrayStore::handle>& sed_keys = _arrays.present_sediments( );
 
-        //for each cell find the prevailing sediment
-        vector<int> prevailing_index( options->geometry( )->total_elements( ), 0 );
-        vector<float> max_concentration( options->geometry( )->total_elements( ), 0.0f );
-
+        //the tables only go to the options when they first appear (or a sediment table changes)
         int index = 0;
-        for(const string& sed_name : sed_keys)
+        for(ArrayStore::handle sed : sed_keys)
         {
-            vector<float> sed_concentration = options->geometry( )->nodal_to_elemental( data_arrays.get_array( sed_name ) );
-
-            for(auto n : IntRange( 0, sed_concentration.size( ) ))
+            const Table* table = &sediments.at( _arrays.name( sed ) ).compaction_table;
+            if(index >= (int)_registered_tables.size( )) _registered_tables.resize( index + 1, nullptr );
+            if(_registered_tables[index] != table)
             {
-                if(sed_concentration[n] > max_concentration[n])
-                {
-                    max_concentration[n] = sed_concentration[n];
-                    prevailing_index[n] = index;
-                }
+                options.add_table( index, *table );
+                _registered_tables[index] = table;
             }
-
-            options.add_table( index, sediments.at( sed_name ).compaction_table );
             index += 1;
         }
 
-        auto& visage_data = data_arrays.get_or_create_array( "dvt_table_index", 0, prevailing_index.size( ) );
-        copy( prevailing_index.begin( ), prevailing_index.end( ), visage_data.begin( ) );
+        //output sized before the concentration pointers are taken (address contract: see ArrayStore.h)
+        auto& visage_data = _arrays[_table_index];
+        visage_data.resize( options->geometry( )->total_elements( ), 0.0f );
+
+        //for each cell the prevailing sediment, in one pass over the nodal concentrations
+        vector<const float*> concentrations;
+        for(ArrayStore::handle sed : sed_keys) concentrations.push_back( _arrays[sed].data( ) );
+
+        transfer( options ).prevailing_elements( concentrations, visage_data.data( ) );
     }
 
+private:
+
+    vector<const Table*> _registered_tables; //compaction table added to the options for each index
+
+    ArrayStore::handle _table_index = _arrays.intern( "dvt_table_index" );
+
 //
 //
 //    virtual void update_compacted_props( const attr_lookup_type& atts, map<string, SedimentDescription> &sediments, VisageDeckSimulationOptions &options, ArrayData &data_arrays )
@@ -121,6 +123,12 @@ public:
 class MechPropertiesEffectiveMedium : public IMechanicalPropertiesInitializer
 {
 public:
+
+    //update_stiffness weakens with the equivalent plastic strain
+    virtual set<string> derived_result_names( bool elastic ) const override
+    {
+        return elastic ? set<string>( ) : set<string>( { "EQPLSTRAIN" } );
+    }
     virtual void update_initial_mech_props( const attr_lookup_type& atts, const map<string, SedimentDescription>& sediments, VisageDeckSimulationOptions& options, ArrayData& data_arrays, int old_nsurf, int new_nsurf )
         override
     {
@@ -163,54 +171,70 @@ public:
     //based on porosity and compaction tables
     void update_stiffness( const attr_lookup_type& atts, map<string, SedimentDescription>& sediments, VisageDeckSimulationOptions& options, ArrayData& data_arrays, const Table& plastic_multiplier )
     {
-        vector<string> tmp = data_arrays.array_names( );
-        vector<string> sed_keys;//find gpm_names SED1,SED2,...SEDN
-        for_each( cbegin( tmp ), cend( tmp ), [&sed_keys, key = "SED"]( const auto& name )
-        {if(name.find( key ) != std::string::npos) sed_keys.push_back( name ); } );
+        bind_arrays( atts, data_arrays );
+        const vector<ArrayStore::handle>& sed_keys = _arrays.present_sediments( ); //SED1,SED2,...SEDN
 
-        vector<float> ym_multiplier( options->geometry( )->total_elements( ), 0.0f ); //volume-weighted stiffness-porosity multiplier
-        for(const string& sed_name : sed_keys)
+        const vector<float>& porosity = _arrays[_porosity];
+        vector<float>& ym_multiplier = _scratch->get( options->geometry( )->total_elements( ), 0.0f ); //volume-weighted stiffness-porosity multiplier
+        for(ArrayStore::handle sed : sed_keys)
         {
-            vector<float> vs_elem_concent = options->geometry( )->nodal_to_elemental( data_arrays.get_array( sed_name ) );
-            auto& stiffness_table = sediments.at( sed_name ).compaction_table;
-
-            vector<float> avg_multiplier = stiffness_table.get_interpolate( data_arrays.get_array( WellKnownVisageNames::ResultsArrayNames::Porosity ) );
-            transform( begin( vs_elem_concent ), end( vs_elem_concent ), begin( avg_multiplier ), begin( avg_multiplier ),
-                       []( float c, float m ) { return m * c; } );
-
-                        //= Emult(phi,SED1)w1 + Emult(phi,SED2)w2 + ....from surfaces [0, surface old_num )
-            for(auto n : IntRange( 0, ym_multiplier.size( ) ))
+            const vector<float>& vs_elem_concent = transfer( options ).to_elements( _arrays[sed], _elemental_buffer );
+
+            //porosity is in [0,1]: the table is resampled once per sediment
+            const Table& stiffness_table = sediments.at( _arrays.name( sed ) ).compaction_table;
+            if((int)_compaction_lookup.size( ) <= sed) _compaction_lookup.resize( sed + 1 );
+            TableEvaluator& lookup = _compaction_lookup[sed];
+            if(!lookup.covers( stiffness_table, 0.0f, 1.0f )) lookup.build( stiffness_table, 0.0f, 1.0f );
+            const vector<float>& avg_multiplier = lookup.evaluate( porosity, _lookup_buffer );
+
+            //= Emult(phi,SED1)w1 + Emult(phi,SED2)w2 + ....from surfaces [0, surface old_num )
+            size_t size = std::min( ym_multiplier.size( ), std::min( avg_multiplier.size( ), vs_elem_concent.size( ) ) );
+            for(size_t n = 0; n < size; n++)
             {
-                ym_multiplier[n] += avg_multiplier[n];
+                ym_multiplier[n] += vs_elem_concent[n] * avg_multiplier[n];
             }
         }
 
         //we add now a second multiplier, which weakens the rock on the basis of equivalent plastic strain.
         //so the final multiplier is the product of two multipliers
-        vector<float> plastic_factor;
-        vector<float>& ym = data_arrays.get_array( WellKnownVisageNames::ResultsArrayNames::Stiffness );
-        vector<float>& init_ym = data_arrays.get_array( "Init" + WellKnownVisageNames::ResultsArrayNames::Stiffness );
+        vector<float>& ym = _arrays[_stiffness];
+        vector<float>& init_ym = _arrays[_init_stiffness];
 
         if(!options->enforce_elastic( ))
         {
             cout << "\n\nConditions are not elastic" << endl;
-            const vector<float>& eq = data_arrays.at( "EQPLSTRAIN" );
-            plastic_factor = plastic_multiplier.get_interpolate( eq );
+            if(!_arrays.contains( _eq_plastic_strain )) throw out_of_range( "[update_stiffness] EQPLSTRAIN not found" );
+            const vector<float>& eq = _arrays[_eq_plastic_strain];
+
+            //the strain only grows: the resampled range doubles when it is exceeded
+            float eq_max = eq.empty( ) ? 0.0f : *std::max_element( eq.begin( ), eq.end( ) );
+            if(!_plastic_lookup.covers( plastic_multiplier, 0.0f, eq_max ))
+                _plastic_lookup.build( plastic_multiplier, 0.0f, std::max( 2.0f * eq_max, _plastic_lookup.empty( ) ? 0.01f : _plastic_lookup.x1( ) ) );
+            const vector<float>& plastic_factor = _plastic_lookup.evaluate( eq, _lookup_buffer );
 
             cout << "\n\nMin plastic factor" << *std::min_element( plastic_factor.begin( ), plastic_factor.end( ) ) << endl;
             cout << "\n\nMax plastic factor" << *std::max_element( plastic_factor.begin( ), plastic_factor.end( ) ) << endl;
+
+            for(auto n : IntRange( 0, ym_multiplier.size( ) ))
+            {
+                ym[n] = init_ym[n] * (ym_multiplier[n] * plastic_factor[n]);
+            }
         }
         else
         {
             cout << "\n\nConditions ARE elastic" << endl;
-            plastic_factor.resize( ym_multiplier.size( ), 1.0f );
-        }
-
-        for(auto n : IntRange( 0, ym_multiplier.size( ) ))
-        {
-            ym[n] = init_ym[n] * (ym_multiplier[n] * plastic_factor[n]);
+            for(auto n : IntRange( 0, ym_multiplier.size( ) ))
+            {
+                ym[n] = init_ym[n] * ym_multiplier[n];
+            }
         }
     }
+
+private:
+
+    vector<TableEvaluator> _compaction_lookup; //by sediment handle
+    TableEvaluator _plastic_lookup;
+    vector<float> _lookup_buffer;
 };
 
 #endif
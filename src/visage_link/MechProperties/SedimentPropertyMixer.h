@@ -0,0 +1,95 @@
+#ifndef SEDIMENT_PROPERTY_MIXER_H_
+#define SEDIMENT_PROPERTY_MIXER_H_ 1
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+
+#include "UIParamerers.h"
+
+using namespace std;
+
+//Sediment-volume-weighted mixing of every sediment property in a single pass.
+//The per-sediment property matrix is taken once from SedimentDescription::properties:
+//    property[p] = sum_s fraction[s] * properties[s][p]
+//Mixing is linear, so the 8-node element average of the fractions is taken first and the
+//properties are produced straight in elemental space.
+class SedimentPropertyMixer
+{
+public:
+
+    SedimentPropertyMixer( ) = default;
+
+    SedimentPropertyMixer( const map<string, SedimentDescription>& sediments, const vector<string>& sed_keys )
+    {
+        _sed_keys = sed_keys;
+        set<string> names = sediments.at( sed_keys[0] ).property_names( );
+        _prop_names.assign( names.begin( ), names.end( ) );
+
+        //row major: one row of properties per sediment
+        _matrix.resize( _sed_keys.size( ) * _prop_names.size( ), 0.0f );
+        for(size_t s = 0; s < _sed_keys.size( ); s++)
+        {
+            const auto& props = sediments.at( _sed_keys[s] ).properties;
+            for(size_t p = 0; p < _prop_names.size( ); p++)
+            {
+                _matrix[s * _prop_names.size( ) + p] = props.at( _prop_names[p] );
+            }
+        }
+    }
+
+    bool matches( const vector<string>& sed_keys ) const { return !_sed_keys.empty( ) && _sed_keys == sed_keys; }
+
+    const vector<string>& property_names( ) const { return _prop_names; }
+
+    const vector<string>& sediment_keys( ) const { return _sed_keys; }
+
+    float property( int sediment, int prop ) const { return _matrix[sediment * _prop_names.size( ) + prop]; }
+
+    //fractions[s] points to nsurfaces*ncols*nrows nodal values of sediment s (sediment_keys() order).
+    //elemental[p] receives (nsurfaces-1)*(ncols-1)*(nrows-1) values of property p (property_names() order).
+    //Each node of each fraction array is read once per neighbouring element row, and all properties are written in the same pass.
+    void mix_to_elements( int ncols, int nrows, int nsurfaces, const vector<const float*>& fractions, const vector<float*>& elemental ) const
+    {
+        const int nsed = (int)_sed_keys.size( ), nprops = (int)_prop_names.size( );
+        const int nxy = ncols * nrows;
+        vector<float>& element_fraction = _element_fraction;
+        element_fraction.resize( nsed );
+
+        int e = 0;
+        for(int k = 0; k < nsurfaces - 1; k++)
+        {
+            for(int j = 0; j < nrows - 1; j++)
+            {
+                const int n0 = k * nxy + j * ncols, n1 = n0 + ncols, n2 = n0 + nxy, n3 = n1 + nxy;
+                for(int i = 0; i < ncols - 1; i++, e++)
+                {
+                    for(int s = 0; s < nsed; s++)
+                    {
+                        const float* f = fractions[s];
+                        element_fraction[s] = 0.125f * (f[n0 + i] + f[n0 + i + 1] + f[n1 + i] + f[n1 + i + 1] +
+                                                        f[n2 + i] + f[n2 + i + 1] + f[n3 + i] + f[n3 + i + 1]);
+                    }
+
+                    for(int p = 0; p < nprops; p++)
+                    {
+                        float value = 0.0f;
+                        for(int s = 0; s < nsed; s++) value += element_fraction[s] * _matrix[s * nprops + p];
+                        elemental[p][e] = value;
+                    }
+                }
+            }
+        }
+    }
+
+private:
+
+    vector<string> _sed_keys;
+    vector<string> _prop_names;
+    vector<float> _matrix;
+    mutable vector<float> _element_fraction; //per element, kept across calls
+};
+
+#endif
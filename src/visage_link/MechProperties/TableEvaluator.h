@@ -0,0 +1,109 @@
+#ifndef TABLE_EVALUATOR_H_
+#define TABLE_EVALUATOR_H_ 1
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "Table.h"
+#include "utils.h"
+
+using namespace std;
+
+//A Table resampled once on a uniform grid over [x0, x1], then evaluated over whole arrays with a
+//clamped linear kernel (no search, no branches: index = (x - x0) / dx).
+//The samples come from Table::get_interpolate itself, so the curve is the table's own. The grid is
+//refined until the table and the resampled curve agree at every cell midpoint (that is where a
+//table knot falling between two samples shows up), up to max_samples.
+//Outside [x0, x1] the end values are used: pick a domain that covers the arguments (see covers( )).
+class TableEvaluator
+{
+public:
+
+    TableEvaluator( ) = default;
+
+    bool build( const Table& table, float x0, float x1, float tolerance = 1.0e-5f, int max_samples = 65537 )
+    {
+        _source = &table;
+        _x0 = x0;
+        _x1 = std::max( x1, x0 + 1.0e-6f );
+
+        for(int n = 129; ; n = 2 * n - 1)
+        {
+            vector<float> x( 2 * n - 1 );
+            for(size_t i = 0; i < x.size( ); i++) x[i] = _x0 + (_x1 - _x0) * i / (x.size( ) - 1);
+            vector<float> y = table.get_interpolate( x ); //samples at even i, midpoints at odd i
+
+            _y.resize( n );
+            float scale = 1.0f, error = 0.0f;
+            for(int i = 0; i < n; i++)
+            {
+                _y[i] = y[2 * i];
+                scale = std::max( scale, fabsf( _y[i] ) );
+            }
+            for(int i = 0; i < n - 1; i++)
+                error = std::max( error, fabsf( y[2 * i + 1] - 0.5f * (_y[i] + _y[i + 1]) ) );
+
+            _inv_dx = (n - 1) / (_x1 - _x0);
+            if(error <= tolerance * scale) return true;
+            if(2 * n - 1 > max_samples) return false; //usable, but coarser than asked
+        }
+    }
+
+    bool empty( ) const { return _y.empty( ); }
+
+    //built from this table, and [x0, x1] is inside the resampled domain
+    bool covers( const Table& table, float x0, float x1 ) const { return !empty( ) && _source == &table && x0 >= _x0 && x1 <= _x1; }
+
+    float x0( ) const { return _x0; }
+
+    float x1( ) const { return _x1; }
+
+    size_t samples( ) const { return _y.size( ); }
+
+    float operator( )( float x ) const
+    {
+        float y;
+        evaluate( &x, &y, 0, 1 );
+        return y;
+    }
+
+    //y[n] = table(x[n]) for n in [first, last)
+    void evaluate( const float* x, float* y, size_t first, size_t last ) const
+    {
+        const float* __restrict xs = x;
+        float* __restrict ys = y;
+        const float* __restrict table = _y.data( );
+        const float x0 = _x0, inv_dx = _inv_dx, tmax = (float)(_y.size( ) - 1);
+        const int imax = (int)_y.size( ) - 2;
+
+        for(size_t n = first; n < last; n++)
+        {
+            float t = std::min( tmax, std::max( 0.0f, (xs[n] - x0) * inv_dx ) );
+            int i = std::min( imax, (int)t );
+            float f = t - i;
+            ys[n] = table[i] + f * (table[i + 1] - table[i]);
+        }
+    }
+
+    //whole arrays, split over threads when large. y is resized to x
+    vector<float>& evaluate( const vector<float>& x, vector<float>& y ) const
+    {
+        y.resize( x.size( ) );
+        const int block = 16384;
+        int nblocks = (int)((x.size( ) + block - 1) / block);
+        parallel_chunks( nblocks, x.size( ), [this, &x, &y, block]( int b1, int b2 )
+                         {
+                             evaluate( x.data( ), y.data( ), (size_t)b1 * block, std::min( x.size( ), (size_t)b2 * block ) );
+                         } );
+        return y;
+    }
+
+private:
+
+    const Table* _source = nullptr;
+    float _x0 = 0.0f, _x1 = 1.0f, _inv_dx = 1.0f;
+    vector<float> _y;
+};
+
+#endif
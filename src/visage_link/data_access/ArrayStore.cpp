@@ -0,0 +1,37 @@
+#include <algorithm>
+
+#include "ArrayStore.h"
+
+ArrayStore::handle ArrayStore::intern( const string& name )
+{
+    auto it = _handles.find( name );
+    if(it != _handles.end( )) return it->second;
+
+    handle h = (handle)_names.size( );
+    _names.push_back( name );
+    _handles[name] = h;
+    _arrays.push_back( (_data && _data->contains( name )) ? &_data->get_array( name ) : nullptr );
+    return h;
+}
+
+ArrayStore::handle ArrayStore::intern_sediment( const string& name )
+{
+    handle h = intern( name );
+    if(find_if( _sediments.begin( ), _sediments.end( ), [h]( handle s ) { return s == h; } ) == _sediments.end( ))
+    {
+        _sediments.push_back( h );
+        sort( _sediments.begin( ), _sediments.end( ), [this]( handle a, handle b ) { return _names[a] < _names[b]; } );
+    }
+    return h;
+}
+
+void ArrayStore::bind( ArrayData& data )
+{
+    _data = &data;
+    for(size_t h = 0; h < _names.size( ); h++)
+        _arrays[h] = data.contains( _names[h] ) ? &data.get_array( _names[h] ) : nullptr;
+
+    _present_sediments.clear( );
+    for(handle s : _sediments)
+        if(_arrays[s]) _present_sediments.push_back( s );
+}
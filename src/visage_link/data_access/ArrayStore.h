@@ -0,0 +1,79 @@
+#ifndef _ARRAY_STORE_H_
+#define _ARRAY_STORE_H_ 1
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "ArrayData.h"
+
+using namespace std;
+
+//Integer handles for the arrays of an ArrayData.
+//Names are interned once (the well-known visage names, Init*, SED1..SEDN when the ui is parsed), then
+//the arrays are resolved once per phase with bind( ) and accessed by handle: no map lookups and no
+//string building in the loops. The arrays themselves stay in the ArrayData (one contiguous column per
+//property), which is what the deck writer and the workers read.
+//ArrayData keeps every array at a fixed address while it exists: creating or resizing another array never
+//moves it, so the bound pointers (and any pointer taken into an array) are valid until that array is removed
+//or resized; arrays created through operator[] are bound as they are created.
+class ArrayStore
+{
+public:
+
+    using handle = int;
+
+    static constexpr handle none = -1;
+
+    //same name, same handle
+    handle intern( const string& name );
+
+    handle intern_sediment( const string& name );
+
+    //none if the name was never interned
+    handle find( const string& name ) const
+    {
+        auto it = _handles.find( name );
+        return it == _handles.end( ) ? none : it->second;
+    }
+
+    const string& name( handle h ) const { return _names[h]; }
+
+    size_t size( ) const { return _names.size( ); }
+
+    //resolves every interned name in data (arrays that do not exist are not created)
+    void bind( ArrayData& data );
+
+    //the array exists in the bound data
+    bool contains( handle h ) const { return h >= 0 && _arrays[h] != nullptr; }
+
+    //the array, created in the bound data if missing
+    vector<float>& operator[]( handle h )
+    {
+        if(!_arrays[h]) _arrays[h] = &(*_data)[_names[h]];
+        return *_arrays[h];
+    }
+
+    //sediment handles in name order (the order of the ArrayData and gpm attribute maps)
+    const vector<handle>& sediments( ) const { return _sediments; }
+
+    //sediments whose nodal arrays exist in the bound data
+    const vector<handle>& present_sediments( ) const { return _present_sediments; }
+
+    vector<string> names( const vector<handle>& handles ) const
+    {
+        vector<string> n;
+        for(handle h : handles) n.push_back( _names[h] );
+        return n;
+    }
+
+private:
+
+    ArrayData* _data = nullptr;
+    vector<string> _names;
+    map<string, handle> _handles;
+    vector<vector<float>*> _arrays;
+    vector<handle> _sediments, _present_sediments;
+};
+
+#endif
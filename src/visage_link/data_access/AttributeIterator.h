@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <iterator>
 #include <vector>
+#include <tuple>
 
 #include "gpm_plugin_helpers.h"
 
@@ -124,6 +125,30 @@ private:
     gpm_attribute_mock_surface* _val;
 };
 
+//raw memory of a gpm surface. Only array_2d_indexer knows its layout, anything else (i.e. the mocks)
+//reports no raw rows and is accessed element by element through operator()
+template<typename SURFACE_TYPE>
+inline float* surface_row_data( const SURFACE_TYPE& surface, size_t row )
+{
+    return nullptr;
+}
+
+template<typename T>
+inline T* surface_row_data( const Slb::Exploration::Gpm::Api::array_2d_indexer<T>& surface, size_t row )
+{
+    //unit column stride: every row is a dense span of num_cols() values
+    return surface.stride[1] == 1 ? surface.begin( ) + row * surface.stride[0] : nullptr;
+}
+
+//the whole surface is one dense span of num_rows()*num_cols() values
+template<typename SURFACE_TYPE>
+inline float* surface_data( const SURFACE_TYPE& surface )
+{
+    float* row0 = surface_row_data( surface, 0 );
+    if(row0 == nullptr) return nullptr;
+    return (surface.num_rows( ) == 1 || surface_row_data( surface, 1 ) == row0 + surface.num_cols( )) ? row0 : nullptr;
+}
+
 template< typename ATT_TYPE>
 class AttributeIterator
 {
@@ -131,17 +156,18 @@ public:
     //using gpm_attribute = vector<Slb::Exploration::Gpm::Api::array_2d_indexer<float>>;
     //using gpm_attribute = gpm_attribute_mock;
 
-    using  iterator_category = std::forward_iterator_tag;
+    using  iterator_category = std::random_access_iterator_tag;
     using  value_type = float;
     using  const_reference = const float&;
     using  reference = float&;
     using  pointer = float*;
-    using  difference_type = int;//ptrdiff_t;
+    using  difference_type = std::ptrdiff_t;
     using  self_type = AttributeIterator;
 
-    explicit AttributeIterator( ATT_TYPE& att, int e = 0 )
+    explicit AttributeIterator( ATT_TYPE& att, difference_type e = 0 )
         :_att( &att ), _element( e ) {
-        ;
+        _ncols = att.size( ) > 0 ? (difference_type)att[0].num_cols( ) : 0;
+        _nxy = att.size( ) > 0 ? _ncols * (difference_type)att[0].num_rows( ) : 0;
     }
 
     AttributeIterator( const AttributeIterator& it ) = default;
@@ -161,9 +187,17 @@ public:
         return !(*this == it);
     }
 
+    bool operator<( const self_type& it ) const { return _element < it._element; }
+
+    bool operator>( const self_type& it ) const { return _element > it._element; }
+
+    bool operator<=( const self_type& it ) const { return _element <= it._element; }
+
+    bool operator>=( const self_type& it ) const { return _element >= it._element; }
+
     self_type operator++( int )  noexcept
     {
-        self_type tmp( *_att, _element );
+        self_type tmp( *this );
         this->operator++( );
         return tmp;
     }
@@ -174,12 +208,65 @@ public:
         return *this;
     }
 
-    reference operator* ( )
+    self_type operator--( int )  noexcept
+    {
+        self_type tmp( *this );
+        this->operator--( );
+        return tmp;
+    }
+
+    self_type& operator--( )  noexcept
+    {
+        _element -= 1;
+        return *this;
+    }
+
+    self_type& operator+=( difference_type n ) noexcept
+    {
+        _element += n;
+        return *this;
+    }
+
+    self_type& operator-=( difference_type n ) noexcept
+    {
+        _element -= n;
+        return *this;
+    }
+
+    self_type operator+( difference_type n ) const noexcept
+    {
+        self_type tmp( *this );
+        return tmp += n;
+    }
+
+    friend self_type operator+( difference_type n, const self_type& it ) noexcept
+    {
+        return it + n;
+    }
+
+    self_type operator-( difference_type n ) const noexcept
+    {
+        self_type tmp( *this );
+        return tmp -= n;
+    }
+
+    difference_type operator-( const self_type& it ) const noexcept
+    {
+        assert( compatible( it ) );
+        return _element - it._element;
+    }
+
+    reference operator* ( ) const
     {
         auto[s, r, c] = indices( _element );
         return  const_cast<float&>(_att->operator[]( s )(r, c));
     }
 
+    reference operator[]( difference_type n ) const
+    {
+        return *(*this + n);
+    }
+
     //const_reference operator-> ( ) const
     //{
     //    auto [s, r, c] = indices( _element );
@@ -198,23 +285,87 @@ public:
 
     static tuple< AttributeIterator, AttributeIterator, AttributeIterator> surface_range( const ATT_TYPE& att, int surface1, int surface2 )
     {
-        int xy_nodes = att[0].num_cols( ) * att[0].num_rows( );
-        
-        return make_tuple( AttributeIterator( att, xy_nodes * surface1 ), AttributeIterator( att, xy_nodes * (surface1 + 1) ), AttributeIterator( att, xy_nodes * surface2 ) );
+        difference_type xy_nodes = att[0].num_cols( ) * att[0].num_rows( );
+        ATT_TYPE& ref = const_cast<ATT_TYPE&>(att);
+        return make_tuple( AttributeIterator( ref, xy_nodes * surface1 ), AttributeIterator( ref, xy_nodes * (surface1 + 1) ), AttributeIterator( ref, xy_nodes * surface2 ) );
 
     }
 
     //[begin surface1, end surface 1, begin surface 2]
     static tuple< AttributeIterator, AttributeIterator> surface_range( const ATT_TYPE& att, int surface_index )
     {
-        int xy_nodes = att[0].num_cols( ) * att[0].num_rows( );
+        difference_type xy_nodes = att[0].num_cols( ) * att[0].num_rows( );
         return make_tuple( AttributeIterator( const_cast<ATT_TYPE&>(att), xy_nodes * surface_index ), AttributeIterator( const_cast<ATT_TYPE&>(att), xy_nodes * (surface_index + 1) ) );
     }
 
+    //[first,last) of the surface as a raw span, or {nullptr,nullptr} when its layout is not dense (strided or a constant)
+    static tuple<pointer, pointer> contiguous_surface( const ATT_TYPE& att, int surface_index )
+    {
+        const auto& surface = att[surface_index];
+        pointer first = surface_data( surface );
+        return first ? make_tuple( first, first + surface.num_cols( ) * surface.num_rows( ) ) : make_tuple( pointer( nullptr ), pointer( nullptr ) );
+    }
 
+    //copies surfaces [k1,k2) into out, row by row. Dense surfaces and rows become plain memory copies
+    template<typename OutIt>
+    static OutIt copy_surfaces( const ATT_TYPE& att, int k1, int k2, OutIt out )
+    {
+        for(int k = k1; k < k2; k++)
+        {
+            const auto& surface = att[k];
+            size_t nrows = surface.num_rows( ), ncols = surface.num_cols( );
+            if(pointer first = surface_data( surface ))
+            {
+                out = std::copy( first, first + nrows * ncols, out );
+            }
+            else if(surface_row_data( surface, 0 ) != nullptr)
+            {
+                for(size_t row = 0; row < nrows; row++)
+                {
+                    pointer first_in_row = surface_row_data( surface, row );
+                    out = std::copy( first_in_row, first_in_row + ncols, out );
+                }
+            }
+            else
+            {
+                auto [it1, it2] = surface_range( att, k );
+                out = std::copy( it1, it2, out );
+            }
+        }
+        return out;
+    }
 
- 
-
+    //copies num_surfaces * nodes per surface values from first into surfaces [k1,k2). Returns the input position after the last value read
+    template<typename InIt>
+    static InIt copy_to_surfaces( InIt first, ATT_TYPE& att, int k1, int k2 )
+    {
+        for(int k = k1; k < k2; k++)
+        {
+            auto& surface = att[k];
+            size_t nrows = surface.num_rows( ), ncols = surface.num_cols( );
+            if(pointer to = surface_data( surface ))
+            {
+                InIt last = std::next( first, nrows * ncols );
+                std::copy( first, last, to );
+                first = last;
+            }
+            else if(surface_row_data( surface, 0 ) != nullptr)
+            {
+                for(size_t row = 0; row < nrows; row++)
+                {
+                    InIt last = std::next( first, ncols );
+                    std::copy( first, last, surface_row_data( surface, row ) );
+                    first = last;
+                }
+            }
+            else
+            {
+                auto [it1, it2] = surface_range( att, k );
+                for(; it1 != it2; ++it1, ++first) *it1 = *first;
+            }
+        }
+        return first;
+    }
 
     bool compatible( self_type const& other ) const
     {
@@ -234,28 +385,27 @@ private:
 
     size_t size( ) const { return num_surfaces( ); }
 
-    int element( ) const
+    difference_type element( ) const
     {
         return _element;//_col + _row * num_cols() + _surface * (num_cols()*num_rows());
     }
 
-    tuple<int, int, int> indices( int el ) const
+    //surface sizes are cached at construction, every surface of an attribute shares the same layout
+    tuple<difference_type, difference_type, difference_type> indices( difference_type el ) const
     {
-        int surf = (int)(el / (num_cols( ) * num_rows( )));
-        int ncols = num_cols( );
-        int nrows = num_rows( );
-        int elexy = el - surf * (num_cols( ) * num_rows( ));
-
-        int row = elexy / num_rows( );
-
-        int col = el - row * num_cols( ) - surf * (num_cols( ) * num_rows( ));
+        difference_type surf = el / _nxy;
+        difference_type elexy = el - surf * _nxy;
+        difference_type row = elexy / _ncols;
+        difference_type col = elexy - row * _ncols;
 
         return make_tuple( surf, row, col );
     }
 
     ATT_TYPE* _att = nullptr;
 
-    int _element;
+    difference_type _element = 0;
+
+    difference_type _ncols = 0, _nxy = 0;
 };
 
 using attr_lookup_type = std::map<std::string, std::vector<Slb::Exploration::Gpm::Api::array_2d_indexer<float>>>;
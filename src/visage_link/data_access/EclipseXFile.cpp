@@ -0,0 +1,189 @@
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "EclipseXFile.h"
+
+namespace
+{
+    //record layout: [int32 length][length bytes][int32 length]
+    const size_t marker_size = 4;
+    const size_t header_size = 16; //char keyword[8], int32 count, char type[4]
+
+    size_t element_size( const string& type )
+    {
+        if(type == "DOUB") return 8;
+        if(type == "CHAR") return 8;
+        if(type == "MESS") return 0;
+        //C0nn: character strings of nn bytes
+        if(type.size( ) == 4 && type[0] == 'C' && all_of( type.begin( ) + 1, type.end( ), ::isdigit )) return stoul( type.substr( 1 ) );
+        return 4; //REAL, INTE, LOGI
+    }
+
+    string trimmed( const unsigned char* chars, size_t n )
+    {
+        string s( reinterpret_cast<const char*>(chars), n );
+        s.erase( s.find_last_not_of( ' ' ) + 1 );
+        return s;
+    }
+}
+
+EclipseXFile::EclipseXFile( const string& file_name ) : _file_name( file_name )
+{
+#ifdef WIN32
+    HANDLE file = CreateFileA( file_name.c_str( ), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if(file == INVALID_HANDLE_VALUE) return;
+    _file_handle = file;
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx( file, &size ) || size.QuadPart == 0) return;
+    _size = (size_t)size.QuadPart;
+
+    HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+    if(mapping == NULL) return;
+    _mapping_handle = mapping;
+
+    _data = static_cast<const unsigned char*>(MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ));
+#else
+    int fd = open( file_name.c_str( ), O_RDONLY );
+    if(fd < 0) return;
+
+    struct stat st;
+    if(fstat( fd, &st ) == 0 && st.st_size > 0)
+    {
+        void* ptr = mmap( nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if(ptr != MAP_FAILED)
+        {
+            _data = static_cast<const unsigned char*>(ptr);
+            _size = (size_t)st.st_size;
+            madvise( ptr, _size, MADV_SEQUENTIAL );
+        }
+    }
+    close( fd ); //the mapping keeps its own reference
+#endif
+
+    if(_data) _indexed = build_index( );
+}
+
+EclipseXFile::~EclipseXFile( )
+{
+#ifdef WIN32
+    if(_data) UnmapViewOfFile( _data );
+    if(_mapping_handle) CloseHandle( _mapping_handle );
+    if(_file_handle) CloseHandle( _file_handle );
+#else
+    if(_data) munmap( const_cast<unsigned char*>(_data), _size );
+#endif
+}
+
+uint32_t EclipseXFile::read_uint32( size_t offset ) const
+{
+    const unsigned char* b = _data + offset;
+    return _big_endian ?
+        (uint32_t( b[0] ) << 24) | (uint32_t( b[1] ) << 16) | (uint32_t( b[2] ) << 8) | uint32_t( b[3] ) :
+        (uint32_t( b[3] ) << 24) | (uint32_t( b[2] ) << 16) | (uint32_t( b[1] ) << 8) | uint32_t( b[0] );
+}
+
+bool EclipseXFile::build_index( )
+{
+    if(_size < 2 * marker_size + header_size) return false;
+
+    //the first record is always a 16 byte header
+    _big_endian = true;
+    if(read_uint32( 0 ) != header_size)
+    {
+        _big_endian = false;
+        if(read_uint32( 0 ) != header_size) return false;
+    }
+
+    size_t pos = 0;
+    while(pos + 2 * marker_size + header_size <= _size)
+    {
+        if(read_uint32( pos ) != header_size) return false;
+
+        const unsigned char* header = _data + pos + marker_size;
+        entry e;
+        e.keyword = trimmed( header, 8 );
+        e.type = trimmed( header + 12, 4 );
+        e.count = read_uint32( pos + marker_size + 8 );
+        pos += 2 * marker_size + header_size;
+        e.offset = pos;
+
+        //skip the data records, as many as needed to hold count values
+        size_t bytes_left = e.count * element_size( e.type );
+        while(bytes_left > 0)
+        {
+            if(pos + marker_size > _size) return false;
+            size_t len = read_uint32( pos );
+            if(len == 0 || len > bytes_left || pos + 2 * marker_size + len > _size) return false;
+            bytes_left -= len;
+            pos += 2 * marker_size + len;
+        }
+
+        if(_index.find( e.keyword ) == _index.end( ))
+        {
+            _keywords.push_back( e.keyword );
+            _index[e.keyword] = e;
+        }
+    }
+
+    return pos == _size;
+}
+
+bool EclipseXFile::read( const string& keyword, float* dst, float factor ) const
+{
+    const entry* e = find( keyword );
+    if(e == nullptr || !is_numeric( e->type )) return false;
+
+    const size_t esize = element_size( e->type );
+    size_t pos = e->offset, done = 0;
+    while(done < e->count)
+    {
+        size_t n = read_uint32( pos ) / esize;
+        const size_t first = pos + marker_size;
+
+        if(e->type == "REAL")
+        {
+            for(size_t i = 0; i < n; i++)
+            {
+                uint32_t bits = read_uint32( first + 4 * i );
+                float v;
+                memcpy( &v, &bits, sizeof( float ) );
+                dst[done + i] = factor * v;
+            }
+        }
+        else if(e->type == "DOUB")
+        {
+            for(size_t i = 0; i < n; i++)
+            {
+                uint64_t hi = read_uint32( first + 8 * i ), lo = read_uint32( first + 8 * i + 4 );
+                uint64_t bits = _big_endian ? (hi << 32) | lo : (lo << 32) | hi;
+                double v;
+                memcpy( &v, &bits, sizeof( double ) );
+                dst[done + i] = factor * (float)v;
+            }
+        }
+        else if(e->type == "INTE")
+        {
+            for(size_t i = 0; i < n; i++) dst[done + i] = factor * (float)(int32_t)read_uint32( first + 4 * i );
+        }
+        else //LOGI: flags stay 0/1, the factor is a unit conversion and does not apply
+        {
+            for(size_t i = 0; i < n; i++) dst[done + i] = read_uint32( first + 4 * i ) != 0 ? 1.0f : 0.0f;
+        }
+
+        done += n;
+        pos = first + n * esize + marker_size;
+    }
+
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef ECLIPSE_X_FILE_H_
+#define ECLIPSE_X_FILE_H_ 1
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+//Read-only view of a binary (unformatted) eclipse X file.
+//The file is memory-mapped once and indexed in a single scan: keyword -> type, count and offset of its first data record.
+//Arrays are then decoded straight from the mapping into the caller's buffer, with an optional scale factor.
+//Both big-endian (the eclipse default) and little-endian files are accepted; the endianness is taken from the first record.
+class EclipseXFile
+{
+public:
+
+    struct entry
+    {
+        string keyword;
+        string type;   //REAL, DOUB, INTE, LOGI, CHAR, MESS...
+        size_t count = 0;
+        size_t offset = 0; //of the first data record marker
+    };
+
+    explicit EclipseXFile( const string& file_name );
+
+    ~EclipseXFile( );
+
+    EclipseXFile( const EclipseXFile& ) = delete;
+
+    EclipseXFile& operator=( const EclipseXFile& ) = delete;
+
+    //false if the file could not be mapped or is not a binary eclipse file (formatted files, truncated records,...)
+    bool is_open( ) const { return _data != nullptr && _indexed; }
+
+    const string& file_name( ) const { return _file_name; }
+
+    //keywords in file order
+    const vector<string>& keywords( ) const { return _keywords; }
+
+    bool contains( const string& keyword ) const { return _index.find( keyword ) != _index.end( ); }
+
+    const entry* find( const string& keyword ) const
+    {
+        auto it = _index.find( keyword );
+        return it == _index.end( ) ? nullptr : &it->second;
+    }
+
+    //true for the types that can be decoded as floats
+    static bool is_numeric( const string& type ) { return type == "REAL" || type == "DOUB" || type == "INTE" || type == "LOGI"; }
+
+    //decodes the first count(keyword) values into dst, each multiplied by factor (LOGI flags are read as 0/1).
+    //dst must hold find(keyword)->count floats. Returns false if the keyword is missing or not numeric
+    bool read( const string& keyword, float* dst, float factor = 1.0f ) const;
+
+private:
+
+    bool build_index( );
+
+    uint32_t read_uint32( size_t offset ) const;
+
+    string _file_name;
+    const unsigned char* _data = nullptr;
+    size_t _size = 0;
+    bool _big_endian = true;
+    bool _indexed = false;
+
+    map<string, entry> _index;
+    vector<string> _keywords;
+
+#ifdef WIN32
+    void* _file_handle = nullptr;
+    void* _mapping_handle = nullptr;
+#endif
+};
+
+#endif
@@ -0,0 +1,158 @@
+#include "GridTransfer.h"
+
+bool GridTransfer::reset( int ncols, int nrows, int nsurfaces )
+{
+    if(ncols == _ncols && nrows == _nrows && nsurfaces == _nsurfaces) return false;
+
+    if(ncols != _ncols) inverse_counts( ncols, _wx );
+    if(nrows != _nrows) inverse_counts( nrows, _wy );
+    inverse_counts( nsurfaces, _wz ); //surfaces appended: only the old top changes, but the array is tiny
+
+    _ncols = ncols;
+    _nrows = nrows;
+    _nsurfaces = nsurfaces;
+    return true;
+}
+
+void GridTransfer::to_elements( const float* nodal, float* elemental, int k1, int k2 ) const
+{
+    const int nelayers = _nsurfaces - 1, necols = _ncols - 1, nerows = _nrows - 1;
+    if(nelayers < 1 || necols < 1 || nerows < 1) return;
+
+    k1 = std::max( 0, k1 );
+    k2 = k2 < 0 ? nelayers : std::min( k2, nelayers );
+    if(k2 <= k1) return;
+
+    const size_t nxy = (size_t)_ncols * _nrows, exy = (size_t)necols * nerows;
+    const int ncols = _ncols;
+
+    _chunk_buffers.prepare( _max_threads );
+    parallel_layers( k2 - k1, (k2 - k1) * nxy, [&, k1, nxy, exy, ncols, necols, nerows]( int first, int last, int chunk )
+                     {
+                         vector<float>& column_sum = _chunk_buffers.get( chunk, ncols );
+                         for(int k = k1 + first; k < k1 + last; k++)
+                         {
+                             for(int j = 0; j < nerows; j++)
+                             {
+                                 const float* __restrict n0 = nodal + k * nxy + (size_t)j * ncols;
+                                 const float* __restrict n1 = n0 + ncols;
+                                 const float* __restrict n2 = n0 + nxy;
+                                 const float* __restrict n3 = n1 + nxy;
+                                 float* __restrict s = column_sum.data( );
+                                 float* __restrict e = elemental + k * exy + (size_t)j * necols;
+
+                                 //4 nodes of each vertical edge, then the 2 edges of each element
+                                 for(int i = 0; i < ncols; i++) s[i] = n0[i] + n1[i] + n2[i] + n3[i];
+                                 for(int i = 0; i < necols; i++) e[i] = 0.125f * (s[i] + s[i + 1]);
+                             }
+                         }
+                     } );
+}
+
+void GridTransfer::prevailing_elements( const vector<const float*>& nodal, float* index ) const
+{
+    const int nelayers = _nsurfaces - 1, necols = _ncols - 1, nerows = _nrows - 1;
+    if(nelayers < 1 || necols < 1 || nerows < 1) return;
+
+    const size_t nxy = (size_t)_ncols * _nrows, exy = (size_t)necols * nerows;
+    const int ncols = _ncols, narrays = (int)nodal.size( );
+
+    _chunk_buffers.prepare( _max_threads );
+    parallel_layers( nelayers, nelayers * nxy * std::max( 1, narrays ), [&, nxy, exy, ncols, necols, nerows, narrays]( int first, int last, int chunk )
+                     {
+                         //column sums, then the best average of every element of the row
+                         vector<float>& buffer = _chunk_buffers.get( chunk, (size_t)ncols + necols );
+                         for(int k = first; k < last; k++)
+                         {
+                             for(int j = 0; j < nerows; j++)
+                             {
+                                 float* __restrict b = buffer.data( ) + ncols;
+                                 float* __restrict e = index + k * exy + (size_t)j * necols;
+                                 std::fill( b, b + necols, 0.0f );
+                                 std::fill( e, e + necols, 0.0f );
+
+                                 for(int a = 0; a < narrays; a++)
+                                 {
+                                     //same sums as to_elements, so the comparisons see the same averages
+                                     const float* __restrict n0 = nodal[a] + k * nxy + (size_t)j * ncols;
+                                     const float* __restrict n1 = n0 + ncols;
+                                     const float* __restrict n2 = n0 + nxy;
+                                     const float* __restrict n3 = n1 + nxy;
+                                     float* __restrict s = buffer.data( );
+                                     const float fa = (float)a;
+
+                                     for(int i = 0; i < ncols; i++) s[i] = n0[i] + n1[i] + n2[i] + n3[i];
+                                     for(int i = 0; i < necols; i++)
+                                     {
+                                         float v = 0.125f * (s[i] + s[i + 1]);
+                                         bool larger = v > b[i];
+                                         b[i] = larger ? v : b[i];
+                                         e[i] = larger ? fa : e[i];
+                                     }
+                                 }
+                             }
+                         }
+                     } );
+}
+
+void GridTransfer::to_nodes( const float* elemental, float* nodal ) const
+{
+    const int nelayers = _nsurfaces - 1, necols = _ncols - 1, nerows = _nrows - 1;
+    if(nelayers < 1 || necols < 1 || nerows < 1) return;
+
+    const size_t nxy = (size_t)_ncols * _nrows;
+    _chunk_buffers.prepare( _max_threads );
+    parallel_layers( _nsurfaces, _nsurfaces * nxy, [&, nxy]( int first, int last, int chunk )
+                     {
+                         vector<float>& scratch = _chunk_buffers.get( chunk, surface_scratch_size( ) );
+                         for(int k = first; k < last; k++) surface_to_nodes( elemental, k, 1.0f, nodal + k * nxy, _ncols, 1, scratch );
+                     } );
+}
+
+void GridTransfer::surface_to_nodes( const float* elemental, int k, float scale, float* out, ptrdiff_t row_stride, ptrdiff_t col_stride, vector<float>& scratch ) const
+{
+    const int nelayers = _nsurfaces - 1, necols = _ncols - 1, nerows = _nrows - 1;
+    if(nelayers < 1 || necols < 1 || nerows < 1 || k < 0 || k >= _nsurfaces) return;
+
+    const size_t exy = (size_t)necols * nerows;
+    scratch.resize( surface_scratch_size( ) );
+    float* __restrict l = scratch.data( );
+    float* __restrict r = l + exy;
+
+    //sum of the element layers below and above the surface
+    const float* below = k > 0 ? elemental + (k - 1) * exy : nullptr;
+    const float* above = k < nelayers ? elemental + k * exy : nullptr;
+    if(below && above)
+        for(size_t n = 0; n < exy; n++) l[n] = below[n] + above[n];
+    else
+        copy( below ? below : above, (below ? below : above) + exy, l );
+
+    for(int j = 0; j < _nrows; j++)
+    {
+        //element rows j-1 and j
+        const float* r0 = j > 0 ? l + (size_t)(j - 1) * necols : nullptr;
+        const float* r1 = j < nerows ? l + (size_t)j * necols : nullptr;
+        if(r0 && r1)
+            for(int i = 0; i < necols; i++) r[i] = r0[i] + r1[i];
+        else
+            copy( r0 ? r0 : r1, (r0 ? r0 : r1) + necols, r );
+
+        //element columns i-1 and i
+        float* row = out + j * row_stride;
+        const float* wx = _wx.data( );
+        const float w = scale * _wy[j] * _wz[k];
+        if(col_stride == 1)
+        {
+            float* __restrict o = row;
+            o[0] = w * wx[0] * r[0];
+            for(int i = 1; i < necols; i++) o[i] = w * wx[i] * (r[i - 1] + r[i]);
+            o[necols] = w * wx[necols] * r[necols - 1];
+        }
+        else
+        {
+            row[0] = w * wx[0] * r[0];
+            for(int i = 1; i < necols; i++) row[i * col_stride] = w * wx[i] * (r[i - 1] + r[i]);
+            row[necols * col_stride] = w * wx[necols] * r[necols - 1];
+        }
+    }
+}
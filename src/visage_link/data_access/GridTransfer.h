@@ -0,0 +1,97 @@
+#ifndef _GRID_TRANSFER_H_
+#define _GRID_TRANSFER_H_ 1
+
+#include <vector>
+#include <algorithm>
+
+#include "utils.h"
+
+using namespace std;
+
+//Node <-> element transfer on the structured grid (ncols x nrows nodes per surface, nsurfaces surfaces):
+//    element(i,j,k) = average of its 8 nodes
+//    node(i,j,k)    = average of its incident elements (1 to 8)
+//Same results as StructuredGrid::nodal_to_elemental / StructuredBase::elemental_to_nodal, but
+//  - the incident element count of a node is the product of one count per axis: the three
+//    axes' inverse counts are cached per grid size. Appending surfaces only extends the z factors.
+//  - the kernels run row by row (contiguous, vectorizable inner loops) and split the layers over threads.
+//  - results go into caller buffers, so a caller can keep one buffer per array across steps. The row
+//    buffers of the kernels are kept too (one per thread), so a call on the same grid allocates nothing.
+//    They make a GridTransfer usable by one thread at a time (the kernels split the work themselves).
+class GridTransfer
+{
+public:
+
+    GridTransfer( ) = default;
+
+    GridTransfer( int ncols, int nrows, int nsurfaces ) { reset( ncols, nrows, nsurfaces ); }
+
+    //no-op if the size did not change. Returns true when the cached factors were rebuilt
+    bool reset( int ncols, int nrows, int nsurfaces );
+
+    int ncols( ) const { return _ncols; }
+    int nrows( ) const { return _nrows; }
+    int nsurfaces( ) const { return _nsurfaces; }
+
+    size_t total_nodes( ) const { return (size_t)_ncols * _nrows * _nsurfaces; }
+
+    size_t total_elements( ) const { return _nsurfaces < 2 ? 0 : (size_t)(_ncols - 1) * (_nrows - 1) * (_nsurfaces - 1); }
+
+    //limit the number of threads (0: hardware concurrency)
+    int& max_threads( ) { return _max_threads; }
+
+    //nodal has total_nodes( ) values, elemental receives total_elements( ) values.
+    //Only the element layers [k1, k2) are computed (k2 < 0: up to the top); the rest of elemental is not touched
+    void to_elements( const float* nodal, float* elemental, int k1 = 0, int k2 = -1 ) const;
+
+    //elemental has total_elements( ) values, nodal receives total_nodes( ) values
+    void to_nodes( const float* elemental, float* nodal ) const;
+
+    //nodes of surface k only, times scale, written to out[row * row_stride + col * col_stride] (a gpm surface
+    //as is). scratch is resized to surface_scratch_size( ); one per thread
+    void surface_to_nodes( const float* elemental, int k, float scale, float* out, ptrdiff_t row_stride, ptrdiff_t col_stride, vector<float>& scratch ) const;
+
+    size_t surface_scratch_size( ) const { return _ncols < 2 || _nrows < 2 ? 0 : (size_t)(_ncols - 1) * (_nrows - 1) + (_ncols - 1); }
+
+    //index of the nodal array whose element average is the largest, for every element, in one pass
+    //over the nodal arrays (no per array element buffers). Ties keep the first array; elements where
+    //every average is <= 0 get 0. index receives total_elements( ) values
+    void prevailing_elements( const vector<const float*>& nodal, float* index ) const;
+
+    vector<float>& to_elements( const vector<float>& nodal, vector<float>& elemental ) const
+    {
+        elemental.resize( total_elements( ) );
+        to_elements( nodal.data( ), elemental.data( ) );
+        return elemental;
+    }
+
+    vector<float>& to_nodes( const vector<float>& elemental, vector<float>& nodal ) const
+    {
+        nodal.resize( total_nodes( ) );
+        to_nodes( elemental.data( ), nodal.data( ) );
+        return nodal;
+    }
+
+    vector<float> to_elements( const vector<float>& nodal ) const { vector<float> e; return to_elements( nodal, e ); }
+
+    vector<float> to_nodes( const vector<float>& elemental ) const { vector<float> n; return to_nodes( elemental, n ); }
+
+private:
+
+    template<typename F>
+    void parallel_layers( int n, size_t work, F f ) const { parallel_chunks( n, work, f, _max_threads ); }
+
+    static void inverse_counts( int n, vector<float>& w )
+    {
+        w.resize( n );
+        for(int i = 0; i < n; i++) w[i] = (i == 0 || i == n - 1) ? 1.0f : 0.5f;
+        if(n == 1) w[0] = 1.0f;
+    }
+
+    int _ncols = 0, _nrows = 0, _nsurfaces = 0;
+    int _max_threads = 0;
+    vector<float> _wx, _wy, _wz; //1 / incident elements along each axis
+    mutable ChunkBuffers _chunk_buffers; //row buffers of the kernels, one per chunk of parallel_layers
+};
+
+#endif
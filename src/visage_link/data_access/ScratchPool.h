@@ -0,0 +1,80 @@
+#ifndef _SCRATCH_POOL_H_
+#define _SCRATCH_POOL_H_ 1
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+using namespace std;
+
+//Scratch float buffers for one coupled step.
+//get( ) hands the buffers out in call order and reset( ) (end of the step) makes them all free again
+//without releasing their memory. A step that asks for the same sizes as the previous one gets the same
+//buffers back, so the steady state allocates nothing. Buffers grow with some headroom, so a model that
+//grows by a few surfaces per step only reallocates now and then.
+//The growth counters are per step (cleared by reset) to check that claim.
+class ScratchPool
+{
+public:
+
+    //n floats, contents undefined. Valid until reset( )
+    vector<float>& get( size_t n )
+    {
+        if(_used == _buffers.size( )) _buffers.emplace_back( new vector<float>( ) );
+        vector<float>& buffer = *_buffers[_used++];
+        if(n > buffer.capacity( ))
+        {
+            size_t old_capacity = buffer.capacity( );
+            buffer.reserve( n + n / 8 );
+            _allocations += 1;
+            _allocated_bytes += sizeof( float ) * (buffer.capacity( ) - old_capacity);
+        }
+        buffer.resize( n );
+        return buffer;
+    }
+
+    //n floats set to value
+    vector<float>& get( size_t n, float value )
+    {
+        vector<float>& buffer = get( n );
+        std::fill( buffer.begin( ), buffer.end( ), value );
+        return buffer;
+    }
+
+    //all the buffers free again, memory kept
+    void reset( )
+    {
+        _used = 0;
+        _allocations = 0;
+        _allocated_bytes = 0;
+    }
+
+    //frees the memory too
+    void release( )
+    {
+        _buffers.clear( );
+        reset( );
+    }
+
+    //buffers that had to grow since the last reset, and by how much
+    size_t allocations( ) const { return _allocations; }
+
+    size_t allocated_bytes( ) const { return _allocated_bytes; }
+
+    size_t buffers_in_use( ) const { return _used; }
+
+    size_t capacity_bytes( ) const
+    {
+        size_t bytes = 0;
+        for(const auto& b : _buffers) bytes += sizeof( float ) * b->capacity( );
+        return bytes;
+    }
+
+private:
+
+    vector<unique_ptr<vector<float>>> _buffers; //fixed addresses: a buffer handed out stays valid while others are added
+    size_t _used = 0;
+    size_t _allocations = 0, _allocated_bytes = 0;
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include <cmath>
+#include <algorithm>
+
+#include "gpm_visage_active_elements.h"
+
+size_t ActiveElements::build( const StructuredGrid& geometry, float tolerance, ArrayData& data )
+{
+    auto [ncols, nrows, nsurfaces, total_nodes, total_elements] = geometry.get_geometry_description( );
+    const int necols = ncols - 1, nerows = nrows - 1;
+    const size_t exy = (size_t)necols * nerows;
+
+    vector<float>& actnum = data.get_or_create_array( array_name );
+    actnum.assign( total_elements, 1.0f );
+
+    size_t inactive = 0;
+    for(int l = 0; l + 1 < nsurfaces; l++)
+    {
+        auto [below, below_end] = geometry.surface_range( l );
+        auto [above, above_end] = geometry.surface_range( l + 1 );
+        float* act = &actnum[l * exy];
+        for(int j = 0; j < nerows; j++)
+            for(int i = 0; i < necols; i++)
+            {
+                size_t n = (size_t)j * ncols + i;
+                float t = std::max( { fabsf( above[n] - below[n] ), fabsf( above[n + 1] - below[n + 1] ),
+                                      fabsf( above[n + ncols] - below[n + ncols] ), fabsf( above[n + ncols + 1] - below[n + ncols + 1] ) } );
+                if(t > tolerance) continue;
+                act[(size_t)j * necols + i] = 0.0f;
+                inactive += 1;
+            }
+    }
+    return inactive;
+}
+
+size_t ActiveElements::fill( vector<float>& values, const vector<float>& actnum, int ncols, int nrows, int nsurfaces )
+{
+    const int necols = ncols - 1, nerows = nrows - 1, nlayers = nsurfaces - 1;
+    const size_t exy = (size_t)necols * nerows, nxy = (size_t)ncols * nrows;
+    if(nlayers < 1 || actnum.size( ) != exy * nlayers) return 0;
+
+    vector<char> active;
+    if(values.size( ) == actnum.size( ))
+    {
+        active.resize( actnum.size( ) );
+        for(size_t e = 0; e < actnum.size( ); e++) active[e] = actnum[e] > 0.5f;
+        return fill_grid( values, active, necols, nerows, nlayers );
+    }
+
+    if(values.size( ) == nxy * nsurfaces)
+    {
+        //a node is active when any of the (up to eight) elements around it is
+        active.assign( values.size( ), 0 );
+        for(int l = 0; l < nlayers; l++)
+            for(int j = 0; j < nerows; j++)
+                for(int i = 0; i < necols; i++)
+                {
+                    if(actnum[l * exy + (size_t)j * necols + i] < 0.5f) continue;
+                    for(int k : { l, l + 1 })
+                    {
+                        size_t n = k * nxy + (size_t)j * ncols + i;
+                        active[n] = active[n + 1] = active[n + ncols] = active[n + ncols + 1] = 1;
+                    }
+                }
+        return fill_grid( values, active, ncols, nrows, nsurfaces );
+    }
+
+    return 0;
+}
+
+size_t ActiveElements::fill_grid( vector<float>& values, const vector<char>& active, int nx, int ny, int nz )
+{
+    const size_t nxy = (size_t)nx * ny;
+    size_t filled = 0;
+
+    //same column: pinched cells sit between the active ones above and below
+    vector<char> done( nxy, 0 );
+    for(size_t c = 0; c < nxy; c++)
+    {
+        int last_active = -1, first_active = -1;
+        for(int k = 0; k < nz && first_active < 0; k++)
+            if(active[k * nxy + c]) first_active = k;
+        if(first_active < 0) continue;
+
+        for(int k = 0; k < nz; k++)
+        {
+            if(active[k * nxy + c]) { last_active = k; continue; }
+            int source = last_active >= 0 ? last_active : first_active;
+            values[k * nxy + c] = values[source * nxy + c];
+            filled += 1;
+        }
+        done[c] = 1;
+    }
+
+    //columns with nothing active: average of the done lateral neighbours, front by front
+    vector<size_t> front;
+    for(bool progress = true; progress; )
+    {
+        front.clear( );
+        for(int j = 0; j < ny; j++)
+            for(int i = 0; i < nx; i++)
+            {
+                size_t c = (size_t)j * nx + i;
+                if(done[c]) continue;
+                bool next_to_done = (i > 0 && done[c - 1]) || (i + 1 < nx && done[c + 1]) || (j > 0 && done[c - nx]) || (j + 1 < ny && done[c + nx]);
+                if(next_to_done) front.push_back( c );
+            }
+
+        for(size_t c : front)
+        {
+            int i = (int)(c % nx), j = (int)(c / nx);
+            size_t neighbours[4];
+            int count = 0;
+            if(i > 0 && done[c - 1]) neighbours[count++] = c - 1;
+            if(i + 1 < nx && done[c + 1]) neighbours[count++] = c + 1;
+            if(j > 0 && done[c - nx]) neighbours[count++] = c - nx;
+            if(j + 1 < ny && done[c + nx]) neighbours[count++] = c + nx;
+
+            for(int k = 0; k < nz; k++)
+            {
+                float sum = 0.0f;
+                for(int n = 0; n < count; n++) sum += values[k * nxy + neighbours[n]];
+                values[k * nxy + c] = sum / count;
+            }
+            filled += nz;
+        }
+
+        //marked after the whole front, so that the fill does not depend on the sweep order
+        for(size_t c : front) done[c] = 1;
+        progress = !front.empty( );
+    }
+
+    return filled;
+}
@@ -0,0 +1,37 @@
+#ifndef _VISAGE_ACTIVE_ELEMENTS_H_
+#define _VISAGE_ACTIVE_ELEMENTS_H_ 1
+
+#include <string>
+#include <vector>
+
+#include "ArrayData.h"
+#include "StructuredGrid.h"
+
+using namespace std;
+
+//Active element map of the solver grid (ACTNUM: 1 active, 0 inactive).
+//An element is inactive when none of its four vertical edges is thicker than the pinchout tolerance:
+//the surfaces above and below coincide there (erosion, no deposition). The map goes to the solver with
+//the other arrays, so the solver leaves those cells out, and the results it did not compute are filled
+//in afterwards from the neighbours: from the nearest active element (node) of the same column, below
+//first, then, for columns with nothing active, from the active lateral neighbours of the same layer.
+class ActiveElements
+{
+public:
+
+    static constexpr const char* array_name = "ACTNUM";
+
+    //writes the map into data[array_name]. Returns the number of inactive elements
+    static size_t build( const StructuredGrid& geometry, float tolerance, ArrayData& data );
+
+    //inactive element values (element arrays) or values of nodes with no active element around (nodal
+    //arrays) filled in from the neighbours. Arrays of any other size are not touched. Returns the values filled
+    static size_t fill( vector<float>& values, const vector<float>& actnum, int ncols, int nrows, int nsurfaces );
+
+private:
+
+    //column first, then from the lateral neighbours. active: per value of a grid of nx*ny*nz
+    static size_t fill_grid( vector<float>& values, const vector<char>& active, int nx, int ny, int nz );
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include <cmath>
+#include <regex>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "gpm_visage_budget_planner.h"
+
+void BudgetPlanner::begin_step( const gpm_plugin_api_timespan& time_span )
+{
+    clock::time_point now = clock::now( );
+    if(!_started)
+    {
+        _run_start = now;
+        _started = true;
+    }
+
+    //the previous cycle is complete now: its host part ran between update_results and this call
+    if(_pending)
+    {
+        _current.cycle_seconds = chrono::duration<double>( now - _step_start ).count( );
+        _samples.push_back( _current );
+        _pending = false;
+    }
+
+    _step_start = now;
+    _time_span = time_span;
+    _solver_seconds = 0.0;
+    _solver_running = false;
+}
+
+void BudgetPlanner::solver_finished( )
+{
+    if(!_solver_running) return;
+    _solver_seconds += seconds_since( _solver_start );
+    _solver_running = false;
+}
+
+void BudgetPlanner::end_step( size_t elements, bool solved, int np )
+{
+    if(!_started) return;
+    _current = { (double)elements, 0.0, solved ? _solver_seconds : 0.0, solved, std::max( 1, np ) };
+    _pending = true;
+}
+
+BudgetPlanner::line BudgetPlanner::fit( const vector<double>& x, const vector<double>& y )
+{
+    line l;
+    if(x.empty( )) return l;
+
+    const double n = (double)x.size( );
+    double mx = 0.0, my = 0.0;
+    for(size_t i = 0; i < x.size( ); i++) { mx += x[i]; my += y[i]; }
+    mx /= n;
+    my /= n;
+
+    double sxx = 0.0, sxy = 0.0;
+    for(size_t i = 0; i < x.size( ); i++)
+    {
+        sxx += (x[i] - mx) * (x[i] - mx);
+        sxy += (x[i] - mx) * (y[i] - my);
+    }
+
+    l.a = my;
+    if(sxx > 0.0 && sxy > 0.0)
+    {
+        l.b = sxy / sxx;
+        l.a = my - l.b * mx;
+    }
+    return l;
+}
+
+BudgetPlanner::plan_type BudgetPlanner::plan( int np ) const
+{
+    plan_type p;
+    p.np = np;
+    p.elapsed_seconds = _started ? seconds_since( _run_start ) : 0.0;
+
+    //steps left, this one included
+    double step_length = _time_span.end - _time_span.start;
+    if(step_length != 0.0)
+        p.remaining_steps = std::max( 0, 1 + (int)ceil( (_run_end_time - _time_span.end) / step_length - 1.0e-6 ) );
+
+    vector<double> solver_x, solver_y, rest_x, rest_y;
+    for(const sample& s : _samples)
+    {
+        rest_x.push_back( s.elements );
+        rest_y.push_back( std::max( 0.0, s.cycle_seconds - s.solver_seconds ) );
+        if(!s.solved) continue;
+        solver_x.push_back( s.elements );
+        solver_y.push_back( s.solver_seconds * s.np );
+    }
+    if(solver_x.size( ) < 2 || _samples.size( ) < 3) return p;
+
+    const line work = fit( solver_x, solver_y ), rest = fit( rest_x, rest_y );
+    const double growth = std::max( 0.0, (_samples.back( ).elements - _samples.front( ).elements) / (_samples.size( ) - 1) );
+    const double elements = _samples.back( ).elements;
+
+    //expected cost of the steps left: one solve every interval steps
+    auto predict = [&]( int interval, int processes )
+    {
+        double seconds = 0.0;
+        for(int s = 1; s <= p.remaining_steps; s++)
+        {
+            double e = elements + growth * s;
+            seconds += rest( e ) + work( e ) / (std::max( 1, processes ) * (double)interval);
+        }
+        return seconds;
+    };
+
+    p.fitted = true;
+    p.remaining_seconds = predict( p.interval, np );
+    if(_budget_seconds <= 0.0) return p;
+
+    const double left = _budget_seconds - p.elapsed_seconds;
+    p.fits = p.remaining_seconds <= left;
+    if(p.fits) return p;
+
+    //more processes first (same results), then fewer solves
+    vector<int> processes = { np };
+    if(np > 0)
+    {
+        for(int n = 2 * np; n < _max_np; n *= 2) processes.push_back( n );
+        if(_max_np > np) processes.push_back( _max_np );
+    }
+
+    for(int n : processes)
+    {
+        double seconds = predict( 1, n );
+        if(seconds <= left)
+        {
+            p.np = n;
+            p.remaining_seconds = seconds;
+            return p;
+        }
+    }
+
+    p.np = processes.back( );
+    for(int interval = 2; interval <= std::max( 1, _max_interval ); interval++)
+    {
+        p.interval = interval;
+        p.remaining_seconds = predict( interval, p.np );
+        if(p.remaining_seconds <= left) return p;
+    }
+    return p;
+}
+
+string BudgetPlanner::report( const plan_type& p ) const
+{
+    auto hms = []( double seconds )
+    {
+        long s = (long)std::max( 0.0, seconds );
+        ostringstream out;
+        out << s / 3600 << "h" << setw( 2 ) << setfill( '0' ) << (s / 60) % 60 << "m" << setw( 2 ) << setfill( '0' ) << s % 60 << "s";
+        return out.str( );
+    };
+
+    ostringstream out;
+    out << "[budget] " << _samples.size( ) << " steps in " << hms( p.elapsed_seconds ) << ", " << p.remaining_steps << " left";
+    if(!p.fitted)
+    {
+        out << ", eta after more solved steps";
+        return out.str( );
+    }
+
+    out << ", eta " << hms( p.remaining_seconds );
+    if(_budget_seconds > 0.0)
+    {
+        out << " (budget " << hms( _budget_seconds ) << (p.fits ? ")" : ", exceeded)");
+        out << ", solving 1 step in " << p.interval;
+        if(p.np > 0) out << " with --np=" << p.np;
+    }
+    return out.str( );
+}
+
+int BudgetPlanner::command_np( const string& command )
+{
+    smatch match;
+    if(!regex_search( command, match, regex( "--np=([0-9]+)" ) )) return 0;
+    return stoi( match[1].str( ) );
+}
+
+string BudgetPlanner::with_np( const string& command, int np )
+{
+    if(np <= 0) return command;
+    return regex_replace( command, regex( "--np=[0-9]+" ), "--np=" + to_string( np ) );
+}
@@ -0,0 +1,100 @@
+#ifndef _VISAGE_BUDGET_PLANNER_H_
+#define _VISAGE_BUDGET_PLANNER_H_ 1
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "gpm_plugin_description.h"
+
+using namespace std;
+
+//Wall-clock cost of the coupled run, and the coupling settings that keep it inside a budget.
+//Every display step records its elements, the wall time of the whole cycle (host included: from one
+//run_timestep to the next) and the time the solver took. Two straight lines are fitted against the
+//element count: the solver work (seconds * np, i.e. ideal scaling with --np) and the rest of the cycle.
+//The model grows by the average number of elements added per step, so the remaining run time is the sum
+//of the predicted cycles up to run_end_time (the gpm time at which the run ends).
+//With a budget, plan( ) picks the smallest --np (up to max_np) that fits solving every step, otherwise
+//max_np and the smallest coupling interval (solve 1 step in interval, up to max_interval) that fits.
+class BudgetPlanner
+{
+public:
+
+    using clock = chrono::steady_clock;
+
+    struct plan_type
+    {
+        int interval = 1;
+        int np = 0;                    //0: the solver command has no --np
+        int remaining_steps = 0;
+        double elapsed_seconds = 0.0;
+        double remaining_seconds = 0.0; //predicted, with interval and np
+        bool fitted = false;            //false: not enough steps recorded yet, nothing predicted
+        bool fits = true;               //within the budget (always true without a budget)
+    };
+
+    //<= 0: no budget, the plan only reports the eta
+    double& budget_seconds( ) { return _budget_seconds; }
+    double& run_end_time( ) { return _run_end_time; }
+    int& max_interval( ) { return _max_interval; }
+    int& max_np( ) { return _max_np; }
+
+    bool& enabled( ) { return _enabled; }
+    bool enabled( ) const { return _enabled; }
+
+    //start of a display step: closes the cycle of the previous one
+    void begin_step( const gpm_plugin_api_timespan& time_span );
+
+    void solver_started( ) { _solver_start = clock::now( ); _solver_running = true; }
+
+    void solver_finished( );
+
+    //end of a display step (results written back). np: solver processes used, 0 if unknown
+    void end_step( size_t elements, bool solved, int np );
+
+    //the settings for the steps left, from the steps recorded so far. np: current --np (0 if unknown)
+    plan_type plan( int np ) const;
+
+    string report( const plan_type& p ) const;
+
+    //--np=N of a solver command, 0 if there is none
+    static int command_np( const string& command );
+
+    static string with_np( const string& command, int np );
+
+private:
+
+    struct sample
+    {
+        double elements;
+        double cycle_seconds;
+        double solver_seconds;
+        bool solved;
+        int np;
+    };
+
+    struct line
+    {
+        double a = 0.0, b = 0.0;
+        double operator( )( double x ) const { return a + b * x; }
+    };
+
+    //least squares; the mean when x does not vary or the slope comes out negative (noise on a few samples)
+    static line fit( const vector<double>& x, const vector<double>& y );
+
+    double seconds_since( clock::time_point t ) const { return chrono::duration<double>( clock::now( ) - t ).count( ); }
+
+    bool _enabled = false;
+    double _budget_seconds = 0.0, _run_end_time = 0.0;
+    int _max_interval = 8, _max_np = 0;
+
+    clock::time_point _run_start, _step_start, _solver_start;
+    bool _started = false, _solver_running = false, _pending = false;
+    double _solver_seconds = 0.0;
+    gpm_plugin_api_timespan _time_span = { 0.0, 0.0 };
+    sample _current = {};
+    vector<sample> _samples;
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+
+#include "gpm_visage_checkpoint.h"
+
+namespace {
+    const char magic[8] = { 'G', 'V', 'S', 'C', 'K', 'P', 'T', '1' };
+    const int32_t version = 1;
+
+    template<typename T>
+    void put( ofstream& out, const T& value ) { out.write( reinterpret_cast<const char*>(&value), sizeof( T ) ); }
+
+    template<typename T>
+    bool get( ifstream& in, T& value ) { return (bool)in.read( reinterpret_cast<char*>(&value), sizeof( T ) ); }
+}
+
+const string CouplerCheckpoint::heights_block = "#HEIGHTS";
+const string CouplerCheckpoint::depths_block = "#DEPTHS";
+const string CouplerCheckpoint::base_block = "#BASE";
+const string CouplerCheckpoint::prev_base_block = "#PREV_BASE";
+
+bool CouplerCheckpoint::write( const string& file_name, const header_type& header, const vector<pair<string, const vector<float>*>>& blocks, string& error )
+{
+    string partial = file_name + ".partial";
+    {
+        ofstream out( partial, ios::binary | ios::trunc );
+        if(!out)
+        {
+            error += "\n[CouplerCheckpoint] cannot write " + partial;
+            return false;
+        }
+
+        out.write( magic, sizeof( magic ) );
+        put( out, version );
+        put( out, header.step );
+        put( out, header.time );
+        put( out, header.ui_hash );
+        put( out, header.ncols );
+        put( out, header.nrows );
+        put( out, header.nsurfaces );
+        put( out, (int32_t)blocks.size( ) );
+
+        for(const auto& [name, values] : blocks)
+        {
+            put( out, (int32_t)name.size( ) );
+            out.write( name.data( ), name.size( ) );
+            put( out, (uint64_t)values->size( ) );
+            out.write( reinterpret_cast<const char*>(values->data( )), sizeof( float ) * values->size( ) );
+        }
+
+        if(!out.flush( ))
+        {
+            error += "\n[CouplerCheckpoint] write failed " + partial;
+            return false;
+        }
+    }
+
+    std::remove( file_name.c_str( ) );
+    if(std::rename( partial.c_str( ), file_name.c_str( ) ) != 0)
+    {
+        error += "\n[CouplerCheckpoint] cannot rename " + partial + " to " + file_name;
+        return false;
+    }
+    return true;
+}
+
+bool CouplerCheckpoint::read( const string& file_name, CouplerCheckpoint& checkpoint, string& error, bool header_only )
+{
+    ifstream in( file_name, ios::binary );
+    char file_magic[sizeof( magic )] = {};
+    int32_t file_version = 0, nblocks = 0;
+    header_type& h = checkpoint.header;
+
+    if(!in || !in.read( file_magic, sizeof( file_magic ) ) || !equal( magic, magic + sizeof( magic ), file_magic ))
+    {
+        error += "\n[CouplerCheckpoint] " + file_name + " is not a checkpoint";
+        return false;
+    }
+
+    bool ok = get( in, file_version ) && file_version == version
+        && get( in, h.step ) && get( in, h.time ) && get( in, h.ui_hash )
+        && get( in, h.ncols ) && get( in, h.nrows ) && get( in, h.nsurfaces ) && get( in, nblocks );
+    if(!ok)
+    {
+        error += "\n[CouplerCheckpoint] bad header in " + file_name;
+        return false;
+    }
+    if(header_only) return true;
+
+    checkpoint.blocks.clear( );
+    for(int b = 0; b < nblocks; b++)
+    {
+        int32_t length = 0;
+        uint64_t count = 0;
+        string name;
+        ok = get( in, length ) && length >= 0 && length < 4096;
+        if(ok)
+        {
+            name.resize( length );
+            ok = (bool)in.read( &name[0], length ) && get( in, count );
+        }
+        if(ok)
+        {
+            vector<float>& values = checkpoint.blocks[name];
+            values.resize( count );
+            ok = (bool)in.read( reinterpret_cast<char*>(values.data( )), sizeof( float ) * count );
+        }
+        if(!ok)
+        {
+            error += "\n[CouplerCheckpoint] truncated block " + to_string( b ) + " in " + file_name;
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t CouplerCheckpoint::hash( const string& text )
+{
+    uint64_t h = 14695981039346656037ull;
+    for(unsigned char c : text)
+    {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
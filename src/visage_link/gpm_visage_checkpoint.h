@@ -0,0 +1,43 @@
+#ifndef _VISAGE_CHECKPOINT_H_
+#define _VISAGE_CHECKPOINT_H_ 1
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+using namespace std;
+
+//Binary checkpoint of the coupler state after a step:
+//    header: magic, version, step, gpm time, ui hash, grid size, number of blocks
+//    blocks: name, count, float values (geometry heights and depths, basement surfaces, every data array)
+//The file is written next to its final name and renamed, so a crash while writing keeps the previous one.
+//Tables and sediments are not stored: they come from the parameters file, and must be the same on restart
+//(ui_hash, a hash of them; the coupler refuses the restart otherwise).
+struct CouplerCheckpoint
+{
+    struct header_type
+    {
+        int32_t step = -1;
+        double time = 0.0; //end of the gpm time span of the step
+        uint64_t ui_hash = 0;
+        int32_t ncols = 0, nrows = 0, nsurfaces = 0;
+    };
+
+    //names of the geometry blocks (data arrays use their own names)
+    static const string heights_block, depths_block, base_block, prev_base_block;
+
+    header_type header;
+    map<string, vector<float>> blocks;
+
+    //blocks are given as views so that the data arrays are not copied
+    static bool write( const string& file_name, const header_type& header, const vector<pair<string, const vector<float>*>>& blocks, string& error );
+
+    //header_only: stops after the header (to find the restart step when the ui is parsed)
+    static bool read( const string& file_name, CouplerCheckpoint& checkpoint, string& error, bool header_only = false );
+
+    //FNV-1a of the parameters file
+    static uint64_t hash( const string& text );
+};
+
+#endif
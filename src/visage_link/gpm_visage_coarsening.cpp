@@ -0,0 +1,176 @@
+#include <cmath>
+#include <algorithm>
+
+#include "gpm_visage_coarsening.h"
+
+LateralCoarsening::axis LateralCoarsening::make_axis( int fine_n, int coarse_n )
+{
+    axis a;
+    const double spacing = (fine_n - 1) / (double)(coarse_n - 1); //fine nodes per coarse cell
+
+    for(int I = 0; I < coarse_n; I++)
+    {
+        //a box centred on the coarse node, narrower near the edges so that it stays centred (linear fields are kept)
+        double centre = I * spacing;
+        double half = std::min( { 0.5 * spacing, centre, (fine_n - 1) - centre } );
+        int first = std::max( 0, (int)ceil( centre - half - 1.0e-9 ) );
+        int last = std::min( fine_n - 1, (int)floor( centre + half + 1.0e-9 ) );
+        if(first > last) first = last = std::min( fine_n - 1, (int)lround( centre ) );
+        a.first.push_back( first );
+        a.last.push_back( last );
+    }
+
+    for(int i = 0; i < fine_n; i++)
+    {
+        double t = i / spacing;
+        int lower = std::min( coarse_n - 2, (int)floor( t ) );
+        a.lower.push_back( lower );
+        a.weight.push_back( (float)(t - lower) );
+    }
+    return a;
+}
+
+void LateralCoarsening::setup( int ncols, int nrows, int factor )
+{
+    _factor = 1;
+    _fine_ncols = ncols;
+    _fine_nrows = nrows;
+    _cols = _rows = axis( );
+    _values.clear( );
+    _reference.clear( );
+    _coarse.clear( );
+    if(factor <= 1 || ncols < 3 || nrows < 3) return;
+
+    auto coarse_n = [factor]( int n ) { return std::min( n, std::max( 2, (int)lround( (n - 1) / (double)factor ) + 1 ) ); };
+    _cols = make_axis( ncols, coarse_n( ncols ) );
+    _rows = make_axis( nrows, coarse_n( nrows ) );
+    _factor = factor;
+}
+
+void LateralCoarsening::restrict_surface( const surface_type& fine, float* coarse )
+{
+    const int nc = ncols( ), nr = nrows( );
+
+    //columns first (every fine row), then rows
+    vector<float>& partial = _partial;
+    partial.resize( (size_t)_fine_nrows * nc );
+    for(int r = 0; r < _fine_nrows; r++)
+        for(int C = 0; C < nc; C++)
+        {
+            float sum = 0.0f;
+            for(int c = _cols.first[C]; c <= _cols.last[C]; c++) sum += fine( r, c );
+            partial[(size_t)r * nc + C] = sum / (_cols.last[C] - _cols.first[C] + 1);
+        }
+
+    for(int R = 0; R < nr; R++)
+    {
+        float* out = coarse + (size_t)R * nc;
+        std::fill( out, out + nc, 0.0f );
+        for(int r = _rows.first[R]; r <= _rows.last[R]; r++)
+        {
+            const float* in = &partial[(size_t)r * nc];
+            for(int C = 0; C < nc; C++) out[C] += in[C];
+        }
+        const float inv = 1.0f / (_rows.last[R] - _rows.first[R] + 1);
+        for(int C = 0; C < nc; C++) out[C] *= inv;
+    }
+}
+
+attr_lookup_type& LateralCoarsening::restrict_attributes( const attr_lookup_type& fine )
+{
+    const size_t nc = ncols( ), nr = nrows( );
+    const gpm_plugin_api_2d_memory_layout dense = { nr, nc, (ptrdiff_t)nc, 1 }, constant = { nr, nc, 0, 0 };
+
+    _coarse.clear( );
+    for(const auto& [name, surfaces] : fine)
+    {
+        vector<vector<float>>& values = _values[name];
+        values.resize( surfaces.size( ) );
+
+        gpm_attribute& coarse = _coarse[name];
+        for(size_t k = 0; k < surfaces.size( ); k++)
+        {
+            const surface_type& surface = surfaces[k];
+            if(surface.stride[0] == 0 && surface.stride[1] == 0)
+            {
+                //a constant is the same on any grid: same value, coarse dimensions
+                coarse.emplace_back( const_cast<float*>(&surface( 0, 0 )), constant );
+                continue;
+            }
+            values[k].resize( nc * nr );
+            restrict_surface( surface, values[k].data( ) );
+            coarse.emplace_back( values[k].data( ), dense );
+        }
+    }
+    return _coarse;
+}
+
+void LateralCoarsening::prolong_surface( const float* coarse, surface_type& fine, bool add ) const
+{
+    const int nc = ncols( );
+    for(int r = 0; r < _fine_nrows; r++)
+    {
+        const float wr = _rows.weight[r];
+        const float* below = coarse + (size_t)_rows.lower[r] * nc;
+        const float* above = below + nc;
+        for(int c = 0; c < _fine_ncols; c++)
+        {
+            const int C = _cols.lower[c];
+            const float wc = _cols.weight[c];
+            float v = (1.0f - wr) * ((1.0f - wc) * below[C] + wc * below[C + 1]) + wr * ((1.0f - wc) * above[C] + wc * above[C + 1]);
+            fine( r, c ) = add ? fine( r, c ) + v : v;
+        }
+    }
+}
+
+void LateralCoarsening::prolong_attributes( const attr_lookup_type& coarse, attr_lookup_type& fine, const vector<string>& names ) const
+{
+    for(const string& name : names)
+    {
+        auto c = coarse.find( name );
+        auto f = fine.find( name );
+        if(c == coarse.end( ) || f == fine.end( )) continue;
+
+        size_t n = std::min( c->second.size( ), f->second.size( ) );
+        for(size_t k = 0; k < n; k++)
+        {
+            const float* values = surface_data( c->second[k] );
+            surface_type& surface = f->second[k];
+            if(values == nullptr || (surface.stride[0] == 0 && surface.stride[1] == 0)) continue;
+            prolong_surface( values, surface, false );
+        }
+    }
+}
+
+void LateralCoarsening::keep_reference( const string& name )
+{
+    auto it = _values.find( name );
+    if(it != _values.end( )) _reference[name] = it->second;
+}
+
+void LateralCoarsening::prolong_change( const string& name, attr_lookup_type& fine ) const
+{
+    auto r = _reference.find( name );
+    auto v = _values.find( name );
+    auto f = fine.find( name );
+    if(r == _reference.end( ) || v == _values.end( ) || f == fine.end( )) return;
+
+    vector<float> change;
+    size_t n = std::min( { r->second.size( ), v->second.size( ), f->second.size( ) } );
+    for(size_t k = 0; k < n; k++)
+    {
+        const vector<float>& before = r->second[k];
+        const vector<float>& after = v->second[k];
+        surface_type& surface = f->second[k];
+        if(before.size( ) != after.size( ) || after.empty( ) || (surface.stride[0] == 0 && surface.stride[1] == 0)) continue;
+
+        change.resize( after.size( ) );
+        bool changed = false;
+        for(size_t i = 0; i < after.size( ); i++)
+        {
+            change[i] = after[i] - before[i];
+            changed = changed || change[i] != 0.0f;
+        }
+        if(changed) prolong_surface( change.data( ), surface, true );
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef _VISAGE_COARSENING_H_
+#define _VISAGE_COARSENING_H_ 1
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "AttributeIterator.h"
+
+using namespace std;
+
+//A geomechanics grid coarser than gpm's in both lateral directions (same extent, same surfaces).
+//restrict_attributes( ) gives the coupler the gpm attributes on the coarse grid: every coarse node is the
+//average of the fine nodes closest to it (sediment fractions still add up to one). The coupler then runs
+//on those as if gpm had the coarse resolution, and its answers go back to the fine grid by bilinear
+//interpolation: the display arrays as they are, TOP as a change (see prolong_change) so that the detail
+//gpm has below the coarse resolution is kept.
+class LateralCoarsening
+{
+public:
+
+    using surface_type = Slb::Exploration::Gpm::Api::array_2d_indexer<float>;
+
+    //factor <= 1: off. The coarse grid has about (n - 1) / factor + 1 nodes per direction, at least 2
+    void setup( int ncols, int nrows, int factor );
+
+    bool enabled( ) const { return _factor > 1; }
+
+    int factor( ) const { return _factor; }
+
+    int ncols( ) const { return (int)_cols.first.size( ); }
+
+    int nrows( ) const { return (int)_rows.first.size( ); }
+
+    //every attribute on the coarse grid (constant surfaces stay constants). Valid until the next call
+    attr_lookup_type& restrict_attributes( const attr_lookup_type& fine );
+
+    //the attributes of the last restrict_attributes( )
+    attr_lookup_type& attributes( ) { return _coarse; }
+
+    //bilinear: fine = coarse (add: fine += coarse)
+    void prolong_surface( const float* coarse, surface_type& fine, bool add ) const;
+
+    //the attributes with these names, coarse -> fine. Constant surfaces are not written
+    void prolong_attributes( const attr_lookup_type& coarse, attr_lookup_type& fine, const vector<string>& names ) const;
+
+    //restricted values of the attribute, before the coupler changes them
+    void keep_reference( const string& name );
+
+    //fine += prolonged (coarse now - reference), surface by surface
+    void prolong_change( const string& name, attr_lookup_type& fine ) const;
+
+private:
+
+    //restriction box [first, last] of every coarse node, and bilinear stencil (lower node, weight of the upper) of every fine node
+    struct axis
+    {
+        vector<int> first, last;
+        vector<int> lower;
+        vector<float> weight;
+    };
+
+    static axis make_axis( int fine_n, int coarse_n );
+
+    void restrict_surface( const surface_type& fine, float* coarse );
+
+    int _factor = 1;
+    int _fine_ncols = 0, _fine_nrows = 0;
+    axis _cols, _rows;
+    vector<float> _partial; //column averages of every fine row, reused by every restricted surface
+
+    map<string, vector<vector<float>>> _values; //coarse surfaces of every attribute, kept between steps
+    attr_lookup_type _coarse;
+    map<string, vector<vector<float>>> _reference;
+};
+
+#endif
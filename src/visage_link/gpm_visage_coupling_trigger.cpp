@@ -0,0 +1,86 @@
+#include <cmath>
+#include <algorithm>
+
+#include "gpm_visage_coupling_trigger.h"
+#include "gpm_visage_warm_start.h"
+
+bool CouplingTrigger::due( StructuredGrid& geometry, const GridTransfer& transfer, ArrayData& data )
+{
+    const int ncols = transfer.ncols( ), nrows = transfer.nrows( ), nsurfaces = transfer.nsurfaces( );
+    const int necols = ncols - 1, nerows = nrows - 1;
+    const size_t exy = (size_t)necols * nerows, nxy = (size_t)ncols * nrows;
+    const bool with_density = data.contains( "DENSITY" ) && data.array_size( "DENSITY" ) == transfer.total_elements( );
+    const float* density = with_density ? data.get_array( "DENSITY" ).data( ) : nullptr;
+
+    _thickness.assign( exy, 0.0f );
+    _load.assign( exy, 0.0f );
+
+    //element column averages of the surface heights, layer by layer
+    vector<float>* below = &_scratch->get( exy );
+    vector<float>* above = &_scratch->get( exy );
+    auto column_heights = [&]( int k, vector<float>& h )
+    {
+        auto [it1, it2] = geometry.surface_range( k );
+        const float* z = &(*it1);
+        for(int j = 0; j < nerows; j++)
+            for(int i = 0; i < necols; i++)
+            {
+                const float* n = z + (size_t)j * ncols + i;
+                h[(size_t)j * necols + i] = 0.25f * (n[0] + n[1] + n[ncols] + n[ncols + 1]);
+            }
+    };
+
+    if(nsurfaces > 1 && nxy > 0)
+    {
+        column_heights( 0, *below );
+        for(int k = 1; k < nsurfaces; k++)
+        {
+            column_heights( k, *above );
+            for(size_t c = 0; c < exy; c++)
+            {
+                float t = fabsf( (*above)[c] - (*below)[c] );
+                _thickness[c] += t;
+                if(density) _load[c] += WarmStart::density_to_stress_gradient * density[(size_t)(k - 1) * exy + c] * t;
+            }
+            swap( below, above );
+        }
+    }
+
+    //no reference (first step, grid changed): solve
+    if(_reference_thickness.size( ) != exy) return true;
+
+    _max_thickness_change = _max_load_change = 0.0f;
+    for(size_t c = 0; c < exy; c++)
+    {
+        _max_thickness_change = std::max( _max_thickness_change, fabsf( _thickness[c] - _reference_thickness[c] ) );
+        _max_load_change = std::max( _max_load_change, fabsf( _load[c] - _reference_load[c] ) );
+    }
+
+    if(_min_interval > 1 && _steps_since_solve + 1 < _min_interval) return false;
+
+    //no threshold: every step (min_interval alone)
+    if(_thickness_threshold <= 0.0f && _load_threshold <= 0.0f && _max_interval <= 0) return true;
+
+    return (_thickness_threshold > 0.0f && _max_thickness_change > _thickness_threshold)
+        || (_load_threshold > 0.0f && _max_load_change > _load_threshold)
+        || (_max_interval > 0 && _steps_since_solve + 1 >= _max_interval);
+}
+
+void CouplingTrigger::solved( )
+{
+    _reference_thickness = _thickness;
+    _reference_load = _load;
+    _steps_since_solve = 0;
+}
+
+bool CouplingTrigger::extend_layers( vector<float>& values, size_t layer_size, size_t total )
+{
+    if(layer_size == 0 || values.empty( ) || values.size( ) >= total || values.size( ) % layer_size != 0 || total % layer_size != 0)
+        return false;
+
+    size_t old_size = values.size( );
+    values.resize( total );
+    for(size_t start = old_size; start < total; start += layer_size)
+        copy( values.begin( ) + (old_size - layer_size), values.begin( ) + old_size, values.begin( ) + start );
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef _VISAGE_COUPLING_TRIGGER_H_
+#define _VISAGE_COUPLING_TRIGGER_H_ 1
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "ArrayData.h"
+#include "StructuredGrid.h"
+#include "GridTransfer.h"
+#include "ScratchPool.h"
+
+using namespace std;
+
+//Decides whether a display step needs a geomechanics solve.
+//Per element column it keeps the thickness (top - base) and the overburden (sum of DENSITY * g * thickness)
+//at the last solve; a solve is due when, in any column, one of them changed by more than its threshold
+//since then, or after max_interval steps. Deposition and erosion both count.
+//min_interval (set by the BudgetPlanner) holds the solves back: never more than one in min_interval steps.
+//With no threshold set it is disabled and every step is solved.
+class CouplingTrigger
+{
+public:
+
+    //metres, MPa, steps. <= 0: not used
+    float& thickness_threshold( ) { return _thickness_threshold; }
+    float& load_threshold( ) { return _load_threshold; }
+    int& max_interval( ) { return _max_interval; }
+    int& min_interval( ) { return _min_interval; }
+
+    bool enabled( ) const { return _thickness_threshold > 0.0f || _load_threshold > 0.0f || _max_interval > 0 || _min_interval > 1; }
+
+    //the per-step scratch buffers (the owner resets them at the end of the step)
+    void use_scratch( shared_ptr<ScratchPool> pool ) { _scratch = pool; }
+
+    //measures the current model against the last solve. True when the solve is due (always the first time)
+    bool due( StructuredGrid& geometry, const GridTransfer& transfer, ArrayData& data );
+
+    //the state measured by the last due( ) becomes the reference
+    void solved( );
+
+    //the step was not solved
+    void skipped( ) { _steps_since_solve += 1; }
+
+    float max_thickness_change( ) const { return _max_thickness_change; }
+    float max_load_change( ) const { return _max_load_change; }
+    int steps_since_solve( ) const { return _steps_since_solve; }
+
+    //last results reused on a grown model: values holds whole layers of layer_size values; the top layer is
+    //repeated up to total values. False (nothing done) if values is not made of whole layers or is not smaller
+    static bool extend_layers( vector<float>& values, size_t layer_size, size_t total );
+
+private:
+
+    float _thickness_threshold = 0.0f, _load_threshold = 0.0f;
+    int _max_interval = 0, _min_interval = 0;
+
+    vector<float> _thickness, _load, _reference_thickness, _reference_load;
+    float _max_thickness_change = 0.0f, _max_load_change = 0.0f;
+    int _steps_since_solve = 0;
+
+    shared_ptr<ScratchPool> _scratch = make_shared<ScratchPool>( );
+};
+
+#endif
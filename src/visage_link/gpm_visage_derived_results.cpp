@@ -0,0 +1,171 @@
+#include <cmath>
+#include <algorithm>
+
+#include "utils.h"
+#include "gpm_visage_derived_results.h"
+
+namespace {
+    //von mises equivalent of the plastic strain tensor (as it was computed in read_visage_results)
+    void eq_plastic_strain( const float* const* in, float* out, size_t first, size_t last )
+    {
+        const float* __restrict exx = in[0];
+        const float* __restrict eyy = in[1];
+        const float* __restrict ezz = in[2];
+        const float* __restrict exy = in[3];
+        const float* __restrict eyz = in[4];
+        const float* __restrict ezx = in[5];
+        float* __restrict eq = out;
+
+        const float a = 2.0f / 3.0f, b = 3.0f / 2.0f, one_third = 1.0f / 3.0f, three_quaters = 0.75f;
+        for(size_t n = first; n < last; n++)
+        {
+            float vxx = one_third * (2.0f * exx[n] - eyy[n] - ezz[n]);
+            float vyy = one_third * (-1.0f * exx[n] + 2.0f * eyy[n] - ezz[n]);
+            float vzz = one_third * (-1.0f * exx[n] - eyy[n] + 2.0f * ezz[n]);
+            float vxy = exy[n] * exy[n] + eyz[n] * eyz[n] + ezx[n] * ezx[n];
+
+            eq[n] = a * sqrtf( b * (vxx * vxx + vyy * vyy + vzz * vzz) + three_quaters * vxy );
+        }
+    }
+
+    //factor * (xx + yy + zz)
+    DerivedResults::kernel_type scaled_trace( float factor )
+    {
+        return [factor]( const float* const* in, float* out, size_t first, size_t last )
+        {
+            const float* __restrict xx = in[0];
+            const float* __restrict yy = in[1];
+            const float* __restrict zz = in[2];
+            float* __restrict v = out;
+            for(size_t n = first; n < last; n++) v[n] = factor * (xx[n] + yy[n] + zz[n]);
+        };
+    }
+
+    void von_mises_stress( const float* const* in, float* out, size_t first, size_t last )
+    {
+        const float* __restrict sxx = in[0];
+        const float* __restrict syy = in[1];
+        const float* __restrict szz = in[2];
+        const float* __restrict sxy = in[3];
+        const float* __restrict syz = in[4];
+        const float* __restrict szx = in[5];
+        float* __restrict vm = out;
+
+        for(size_t n = first; n < last; n++)
+        {
+            float d1 = sxx[n] - syy[n], d2 = syy[n] - szz[n], d3 = szz[n] - sxx[n];
+            float shear = sxy[n] * sxy[n] + syz[n] * syz[n] + szx[n] * szx[n];
+            vm[n] = sqrtf( 0.5f * (d1 * d1 + d2 * d2 + d3 * d3) + 3.0f * shear );
+        }
+    }
+
+    //sigma1 - sigma3, from the closed form eigenvalues of the symmetric tensor
+    void differential_stress( const float* const* in, float* out, size_t first, size_t last )
+    {
+        const float* __restrict sxx = in[0];
+        const float* __restrict syy = in[1];
+        const float* __restrict szz = in[2];
+        const float* __restrict sxy = in[3];
+        const float* __restrict syz = in[4];
+        const float* __restrict szx = in[5];
+        float* __restrict diff = out;
+
+        const float pi_third = 1.04719755f, sqrt3 = 1.73205081f;
+        for(size_t n = first; n < last; n++)
+        {
+            float q = (sxx[n] + syy[n] + szz[n]) / 3.0f;
+            float a = sxx[n] - q, b = syy[n] - q, c = szz[n] - q;
+            float d = sxy[n], e = syz[n], f = szx[n];
+
+            float p2 = a * a + b * b + c * c + 2.0f * (d * d + e * e + f * f);
+            float p = sqrtf( p2 / 6.0f );
+            float det = a * (b * c - e * e) - d * (d * c - e * f) + f * (d * e - b * f);
+            float r = p > 0.0f ? det / (2.0f * p * p * p) : 0.0f;
+            r = std::min( 1.0f, std::max( -1.0f, r ) );
+            float phi = acosf( r ) / 3.0f;
+
+            //e1 - e3 = 2p (cos(phi) - cos(phi + 2pi/3))
+            diff[n] = 2.0f * sqrt3 * p * sinf( phi + pi_third );
+        }
+    }
+}
+
+DerivedResults::DerivedResults( )
+{
+    const vector<string> plastic_strain = { "PLSTRNXX", "PLSTRNYY", "PLSTRNZZ", "PLSTRNXY", "PLSTRNYZ", "PLSTRNZX" };
+    const vector<string> stress = { "STRESSXX", "STRESSYY", "STRESSZZ", "STRESSXY", "STRESSYZ", "STRESSZX" };
+
+    add( { "EQPLSTRAIN", plastic_strain, eq_plastic_strain } );
+    add( { "VOLSTRAIN", { "STRAINXX", "STRAINYY", "STRAINZZ" }, scaled_trace( 1.0f ) } );
+    add( { "MEANEFFSTR", { "EFFSTRXX", "EFFSTRYY", "EFFSTRZZ" }, scaled_trace( 1.0f / 3.0f ) } );
+    add( { "VONMISES", stress, von_mises_stress } );
+    add( { "DIFFSTRESS", stress, differential_stress } );
+}
+
+const set<string>& DerivedResults::builtin_names( )
+{
+    static const set<string> names = []( )
+    {
+        set<string> all;
+        for(const auto& q : DerivedResults( )._quantities) all.insert( q.first );
+        return all;
+    }( );
+    return names;
+}
+
+set<string> DerivedResults::derived_names( const set<string>& wanted ) const
+{
+    set<string> names;
+    for(const string& name : wanted)
+        if(contains( name )) names.insert( name );
+    return names;
+}
+
+set<string> DerivedResults::input_names( const set<string>& wanted ) const
+{
+    set<string> names;
+    for(const string& name : derived_names( wanted ))
+    {
+        const auto& inputs = _quantities.at( name ).inputs;
+        names.insert( inputs.begin( ), inputs.end( ) );
+    }
+    return names;
+}
+
+int DerivedResults::compute( const set<string>& wanted, ArrayData& data, string& error ) const
+{
+    int computed = 0;
+    for(const string& name : derived_names( wanted ))
+    {
+        const quantity& q = _quantities.at( name );
+
+        size_t size = data.array_size( q.inputs[0] );
+        bool complete = size > 0;
+        for(const string& input : q.inputs)
+            complete = complete && data.contains( input ) && data.array_size( input ) == size;
+
+        if(!complete)
+        {
+            error += "\n[DerivedResults] inputs of " + name + " not available";
+            continue;
+        }
+
+        //output sized before the input pointers are taken (address contract: see ArrayStore.h)
+        vector<float>& out = data.get_or_create_array( name );
+        out.resize( size, 0.0f );
+
+        vector<const float*> in;
+        for(const string& input : q.inputs) in.push_back( data.get_array( input ).data( ) );
+
+        //chunks of elements over threads
+        const int block = 16384;
+        int nblocks = (int)((size + block - 1) / block);
+        parallel_chunks( nblocks, size * q.inputs.size( ), [&q, &in, &out, size, block]( int b1, int b2 )
+                         {
+                             q.kernel( in.data( ), out.data( ), (size_t)b1 * block, std::min( size, (size_t)b2 * block ) );
+                         } );
+        computed += 1;
+    }
+
+    return computed;
+}
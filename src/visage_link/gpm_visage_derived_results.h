@@ -0,0 +1,58 @@
+#ifndef _VISAGE_DERIVED_RESULTS_H_
+#define _VISAGE_DERIVED_RESULTS_H_ 1
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <functional>
+
+#include "ArrayData.h"
+
+using namespace std;
+
+//Results computed from the arrays read back from the solver (EQPLSTRAIN, VOLSTRAIN, ...).
+//Every quantity declares its input arrays; compute( ) only evaluates the ones asked for, and
+//the results reader only needs to read their inputs (input_names( )).
+//Kernels read one array per input (structure of arrays) over a range of elements, and the
+//element range is split over threads.
+class DerivedResults
+{
+public:
+
+    //out[n] for n in [first, last) from in[0][n], in[1][n],... (inputs in declaration order)
+    using kernel_type = function<void( const float* const* in, float* out, size_t first, size_t last )>;
+
+    struct quantity
+    {
+        string name;
+        vector<string> inputs;
+        kernel_type kernel;
+    };
+
+    //the built-in quantities
+    DerivedResults( );
+
+    //adds or replaces a quantity
+    void add( const quantity& q ) { _quantities[q.name] = q; }
+
+    bool contains( const string& name ) const { return _quantities.find( name ) != _quantities.end( ); }
+
+    //the names in wanted that are derived quantities
+    set<string> derived_names( const set<string>& wanted ) const;
+
+    //arrays to read from the results so that the derived quantities in wanted can be computed
+    set<string> input_names( const set<string>& wanted ) const;
+
+    //computes the derived quantities in wanted whose inputs are all in data. Returns the number computed
+    int  compute( const set<string>& wanted, ArrayData& data, string& error ) const;
+
+    //names of the built-in quantities (for the json parser, before any coupler exists)
+    static const set<string>& builtin_names( );
+
+private:
+
+    map<string, quantity> _quantities;
+};
+
+#endif
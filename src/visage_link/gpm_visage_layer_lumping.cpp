@@ -0,0 +1,219 @@
+#include <cmath>
+#include <algorithm>
+
+#include "gpm_visage_layer_lumping.h"
+
+void LayerLumping::plan( const StructuredGrid& geometry )
+{
+    auto [ncols, nrows, nsurfaces, total_nodes, total_elements] = geometry.get_geometry_description( );
+    const int necols = ncols - 1, nerows = nrows - 1;
+    _nxy = (size_t)ncols * nrows;
+    _exy = (size_t)necols * nerows;
+    _full_nsurfaces = nsurfaces;
+
+    _heights.clear( );
+    for(int k = 0; k < nsurfaces; k++)
+    {
+        auto [it1, it2] = geometry.surface_range( k );
+        _heights.insert( _heights.end( ), it1, it2 );
+    }
+
+    //element column thickness: average of the four corners
+    const int nlayers = std::max( 0, nsurfaces - 1 );
+    _thickness.assign( _exy * nlayers, 0.0f );
+    for(int l = 0; l < nlayers; l++)
+    {
+        const float* below = &_heights[l * _nxy];
+        const float* above = below + _nxy;
+        float* t = &_thickness[l * _exy];
+        for(int j = 0; j < nerows; j++)
+            for(int i = 0; i < necols; i++)
+            {
+                size_t n = (size_t)j * ncols + i;
+                t[(size_t)j * necols + i] = 0.25f * (fabsf( above[n] - below[n] ) + fabsf( above[n + 1] - below[n + 1] )
+                                                     + fabsf( above[n + ncols] - below[n + ncols] ) + fabsf( above[n + ncols + 1] - below[n + ncols + 1] ));
+            }
+    }
+
+    //bottom up: a layer joins the group below while the group stays under the threshold in every column
+    _kept.assign( 1, 0 );
+    const int first_kept_layer = std::max( 0, nlayers - _keep_top );
+    vector<float> group( _exy, 0.0f );
+    bool empty_group = true;
+    for(int l = 0; l < first_kept_layer; l++)
+    {
+        const float* t = &_thickness[l * _exy];
+        bool fits = true;
+        for(size_t c = 0; c < _exy && fits; c++) fits = group[c] + t[c] <= _thickness_threshold;
+
+        if(!empty_group && !fits)
+        {
+            _kept.push_back( l );
+            std::fill( group.begin( ), group.end( ), 0.0f );
+        }
+        for(size_t c = 0; c < _exy; c++) group[c] += t[c];
+        empty_group = false;
+    }
+
+    for(int k = std::max( 1, first_kept_layer ); k <= nlayers; k++)
+        if(k != _kept.back( )) _kept.push_back( k );
+}
+
+void LayerLumping::begin( StructuredGrid& geometry, ArrayData& data )
+{
+    _active = false;
+    if(!enabled( )) return;
+
+    plan( geometry );
+    if(_kept.size( ) >= _full_nsurfaces) return;
+
+    const size_t full_nodes = _nxy * _full_nsurfaces, full_elements = _exy * (_full_nsurfaces - 1);
+    _full_arrays.clear( );
+    for(const string& name : data.array_names( ))
+    {
+        vector<float>& values = data.get_array( name );
+        vector<float> merged;
+        if(values.size( ) == full_elements)
+            merge_elements( name, values, merged );
+        else if(values.size( ) == full_nodes)
+            merge_nodes( values, merged );
+        else
+            continue; //constants, tables
+
+        _full_arrays[name].swap( values );
+        values.swap( merged );
+    }
+
+    //surfaces kept moved down over the merged ones (kept[j] >= j)
+    _full_geometry = geometry;
+    for(size_t j = 0; j < _kept.size( ); j++)
+    {
+        if(_kept[j] == (int)j) continue;
+        auto [it1, it2] = geometry.surface_range( _kept[j] );
+        std::copy( it1, it2, geometry->begin_surface( (int)j ) );
+        geometry->get_local_depths( (int)j ) = geometry->get_local_depths( _kept[j] );
+    }
+    geometry->set_num_surfaces( (int)_kept.size( ) );
+    _active = true;
+}
+
+void LayerLumping::end( StructuredGrid& geometry, ArrayData& data, const set<string>& results )
+{
+    if(!_active) return;
+
+    geometry = _full_geometry;
+
+    const size_t merged_nodes = _nxy * _kept.size( ), merged_elements = _exy * (_kept.size( ) - 1);
+    for(const string& name : data.array_names( ))
+    {
+        vector<float>& values = data.get_array( name );
+        auto full = _full_arrays.find( name );
+        if(full != _full_arrays.end( ) && results.find( name ) == results.end( ))
+        {
+            values.swap( full->second );
+        }
+        else
+        {
+            vector<float> expanded;
+            if(values.size( ) == merged_elements)
+                expand_elements( values, expanded );
+            else if(values.size( ) == merged_nodes)
+                expand_nodes( values, expanded );
+            else
+                continue;
+            values.swap( expanded );
+        }
+        if(full != _full_arrays.end( )) _full_arrays.erase( full );
+    }
+
+    //anything the solve removed
+    for(auto& [name, values] : _full_arrays) data.get_or_create_array( name ).swap( values );
+
+    _full_arrays.clear( );
+    _active = false;
+}
+
+void LayerLumping::merge_elements( const string& name, const vector<float>& full, vector<float>& merged ) const
+{
+    const bool categorical = _categorical.find( name ) != _categorical.end( );
+    merged.assign( _exy * (_kept.size( ) - 1), 0.0f );
+
+    for(size_t j = 0; j + 1 < _kept.size( ); j++)
+    {
+        float* out = &merged[j * _exy];
+        const int a = _kept[j], b = _kept[j + 1];
+        if(b - a == 1)
+        {
+            std::copy( full.begin( ) + a * _exy, full.begin( ) + b * _exy, out );
+            continue;
+        }
+
+        for(size_t c = 0; c < _exy; c++)
+        {
+            float sum = 0.0f, volume = 0.0f, thickest = -1.0f;
+            for(int l = a; l < b; l++)
+            {
+                float t = _thickness[l * _exy + c], v = full[l * _exy + c];
+                if(categorical)
+                {
+                    if(t > thickest) { thickest = t; out[c] = v; }
+                    continue;
+                }
+                sum += v * t;
+                volume += t;
+            }
+            if(categorical) continue;
+
+            if(volume > 0.0f)
+            {
+                out[c] = sum / volume;
+            }
+            else
+            {
+                //pinched out column: plain average
+                for(int l = a; l < b; l++) out[c] += full[l * _exy + c];
+                out[c] /= (b - a);
+            }
+        }
+    }
+}
+
+void LayerLumping::expand_elements( const vector<float>& merged, vector<float>& full ) const
+{
+    full.resize( _exy * (_full_nsurfaces - 1) );
+    for(size_t j = 0; j + 1 < _kept.size( ); j++)
+        for(int l = _kept[j]; l < _kept[j + 1]; l++)
+            std::copy( merged.begin( ) + j * _exy, merged.begin( ) + (j + 1) * _exy, full.begin( ) + l * _exy );
+}
+
+void LayerLumping::merge_nodes( const vector<float>& full, vector<float>& merged ) const
+{
+    merged.resize( _nxy * _kept.size( ) );
+    for(size_t j = 0; j < _kept.size( ); j++)
+        std::copy( full.begin( ) + _kept[j] * _nxy, full.begin( ) + (_kept[j] + 1) * _nxy, merged.begin( ) + j * _nxy );
+}
+
+void LayerLumping::expand_nodes( const vector<float>& merged, vector<float>& full ) const
+{
+    full.resize( _nxy * _full_nsurfaces );
+    for(size_t j = 0; j + 1 < _kept.size( ); j++)
+    {
+        const int a = _kept[j], b = _kept[j + 1];
+        const float* va = &merged[j * _nxy];
+        const float* vb = va + _nxy;
+        const float* za = &_heights[a * _nxy];
+        const float* zb = &_heights[b * _nxy];
+
+        for(int k = a; k <= b; k++)
+        {
+            const float* zk = &_heights[k * _nxy];
+            float* out = &full[k * _nxy];
+            for(size_t n = 0; n < _nxy; n++)
+            {
+                float dz = zb[n] - za[n];
+                float f = fabsf( dz ) > 0.0f ? (zk[n] - za[n]) / dz : (float)(k - a) / (b - a);
+                out[n] = va[n] + f * (vb[n] - va[n]);
+            }
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef _VISAGE_LAYER_LUMPING_H_
+#define _VISAGE_LAYER_LUMPING_H_ 1
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+
+#include "ArrayData.h"
+#include "StructuredGrid.h"
+
+using namespace std;
+
+//Old, thin element layers merged into thicker ones for the solve.
+//The youngest keep_top layers are solved as they are. Below them, layers are merged from the bottom up
+//while the merged layer stays thinner than the threshold in every column. Only the surfaces between the
+//merged layers are kept in the solver grid.
+//begin( ) turns the geometry and the arrays into that grid for the solve: element arrays volume averaged
+//(categorical ones, e.g. dvt_table_index, take the value of the thickest layer), nodal arrays sampled at
+//the kept surfaces. end( ) goes back to every layer: the results of the solve are expanded (elements: the
+//value of their merged layer, nodes: linear in height between the kept surfaces, so the merged layer
+//deforms as a block and the surfaces inside it follow), everything else gets its full arrays back.
+class LayerLumping
+{
+public:
+
+    LayerLumping( ) : _categorical( { "dvt_table_index" } ) {}
+
+    //metres (<= 0: off), layers
+    float& thickness_threshold( ) { return _thickness_threshold; }
+    int& keep_top( ) { return _keep_top; }
+
+    set<string>& categorical( ) { return _categorical; }
+
+    bool enabled( ) const { return _thickness_threshold > 0.0f; }
+
+    //between begin( ) and end( )
+    bool active( ) const { return _active; }
+
+    //surfaces of the geometry kept in the solver grid (0 and the top always)
+    const vector<int>& kept_surfaces( ) const { return _kept; }
+
+    //layers of the full model minus layers of the solver grid
+    int layers_merged( ) const { return _active ? (int)_full_nsurfaces - (int)_kept.size( ) : 0; }
+
+    //plans the merge on the geometry, then replaces geometry and arrays with the merged ones. Nothing
+    //is done (and active( ) stays false) when no two layers can be merged
+    void begin( StructuredGrid& geometry, ArrayData& data );
+
+    //results: the arrays written by the solve (they are expanded, the others restored)
+    void end( StructuredGrid& geometry, ArrayData& data, const set<string>& results );
+
+private:
+
+    void plan( const StructuredGrid& geometry );
+
+    void merge_elements( const string& name, const vector<float>& full, vector<float>& merged ) const;
+
+    void expand_elements( const vector<float>& merged, vector<float>& full ) const;
+
+    void merge_nodes( const vector<float>& full, vector<float>& merged ) const;
+
+    void expand_nodes( const vector<float>& merged, vector<float>& full ) const;
+
+    float _thickness_threshold = 0.0f;
+    int _keep_top = 10;
+    set<string> _categorical;
+
+    bool _active = false;
+    vector<int> _kept;
+    size_t _nxy = 0, _exy = 0, _full_nsurfaces = 0;
+    vector<float> _thickness;          //element column thickness of every full layer
+    vector<float> _heights;            //full surface heights, for the nodal expansion
+    StructuredGrid _full_geometry;
+    map<string, vector<float>> _full_arrays;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "gpm_visage_profiler.h"
+
+namespace {
+    string json_escape( const string& s )
+    {
+        string out;
+        for(char c : s)
+        {
+            if(c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out;
+    }
+}
+
+int Profiler::open( const string& name )
+{
+    if(!_enabled) return -1;
+
+    string path = _open.empty( ) ? name : _events[_open.back( )].path + "/" + name;
+    _events.push_back( { name, path, _step, now_us( ), -1.0 } );
+    _open.push_back( (int)_events.size( ) - 1 );
+    return _open.back( );
+}
+
+void Profiler::close( int scope )
+{
+    if(scope < 0 || scope >= (int)_events.size( )) return;
+
+    event& e = _events[scope];
+    e.duration = now_us( ) - e.start;
+
+    //scopes close in reverse order; anything still above this one was left open
+    while(!_open.empty( ) && _open.back( ) >= scope) _open.pop_back( );
+
+    scope_total& total = _steps[e.step].scopes[e.path];
+    total.calls += 1;
+    total.seconds += 1.0e-6 * e.duration;
+}
+
+void Profiler::count( const string& counter, double value )
+{
+    if(!_enabled) return;
+
+    double& total = _steps[_step].counters[counter];
+    total += value;
+    _samples.push_back( { counter, _step, now_us( ), total } );
+}
+
+string Profiler::step_report( int step ) const
+{
+    auto it = _steps.find( step );
+    if(it == _steps.end( )) return "";
+
+    stringstream out;
+    out << "[Profiler] step " << step << endl;
+    for(const auto& s : it->second.scopes)
+    {
+        int depth = (int)count_if( s.first.begin( ), s.first.end( ), []( char c ) { return c == '/'; } );
+        out << "    " << string( 2 * depth, ' ' ) << left << setw( 32 - 2 * depth ) << s.first.substr( s.first.find_last_of( '/' ) + 1 )
+            << right << fixed << setprecision( 3 ) << setw( 12 ) << s.second.seconds << " s";
+        if(s.second.calls > 1) out << "  (" << s.second.calls << " calls)";
+        out << endl;
+    }
+    for(const auto& c : it->second.counters)
+        out << "    " << left << setw( 32 ) << c.first << right << setw( 16 ) << setprecision( 0 ) << c.second << endl;
+
+    return out.str( );
+}
+
+bool Profiler::write_chrome_trace( const string& file_name ) const
+{
+    ofstream out( file_name );
+    if(!out) return false;
+
+    out << "{\n\"traceEvents\": [\n";
+    bool first = true;
+    for(const event& e : _events)
+    {
+        if(e.duration < 0.0) continue;
+        out << (first ? "" : ",\n") << "{\"name\":\"" << json_escape( e.name ) << "\",\"cat\":\"coupler\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+            << ",\"ts\":" << fixed << setprecision( 1 ) << e.start << ",\"dur\":" << e.duration << ",\"args\":{\"step\":" << e.step << "}}";
+        first = false;
+    }
+    for(const counter_sample& c : _samples)
+    {
+        out << (first ? "" : ",\n") << "{\"name\":\"" << json_escape( c.name ) << "\",\"ph\":\"C\",\"pid\":1,\"tid\":1"
+            << ",\"ts\":" << fixed << setprecision( 1 ) << c.time << ",\"args\":{\"value\":" << setprecision( 0 ) << c.value << "}}";
+        first = false;
+    }
+    out << "\n],\n\"steps\": [\n";
+
+    first = true;
+    for(const auto& s : _steps)
+    {
+        out << (first ? "" : ",\n") << "{\"step\":" << s.first << ",\"scopes\":{";
+        bool first_scope = true;
+        for(const auto& t : s.second.scopes)
+        {
+            out << (first_scope ? "" : ",") << "\"" << json_escape( t.first ) << "\":{\"calls\":" << t.second.calls
+                << ",\"seconds\":" << setprecision( 6 ) << t.second.seconds << "}";
+            first_scope = false;
+        }
+        out << "},\"counters\":{";
+        bool first_counter = true;
+        for(const auto& c : s.second.counters)
+        {
+            out << (first_counter ? "" : ",") << "\"" << json_escape( c.first ) << "\":" << setprecision( 0 ) << c.second;
+            first_counter = false;
+        }
+        out << "}}";
+        first = false;
+    }
+    out << "\n]\n}\n";
+
+    return (bool)out;
+}
@@ -0,0 +1,103 @@
+#ifndef _VISAGE_PROFILER_H_
+#define _VISAGE_PROFILER_H_ 1
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+
+using namespace std;
+
+//Nested wall-clock scopes and counters of the coupler, aggregated per display step.
+//Scopes are opened/closed on the host thread (ScopedTimer); a disabled profiler costs a branch per scope.
+//Everything is kept in memory: step_report( ) prints one step, write_chrome_trace( ) dumps the whole run (once, at the end)
+//(chrome://tracing or https://ui.perfetto.dev) with the per-step totals under "steps".
+class Profiler
+{
+public:
+
+    using clock = chrono::steady_clock;
+
+    struct scope_total { int calls = 0; double seconds = 0.0; };
+
+    struct step_totals
+    {
+        map<string, scope_total> scopes; //by path, e.g. "run_timestep/deck"
+        map<string, double> counters;
+    };
+
+    Profiler( ) : _origin( clock::now( ) ) {}
+
+    bool& enabled( ) { return _enabled; }
+
+    bool enabled( ) const { return _enabled; }
+
+    //scopes and counters from here on are added to step
+    void begin_step( int step ) { _step = step; }
+
+    int step( ) const { return _step; }
+
+    //returns the scope index to pass to close( ), -1 when disabled
+    int  open( const string& name );
+
+    void close( int scope );
+
+    //adds value to the counter (bytes_read, bytes_written, elements,...) of the current step
+    void count( const string& counter, double value );
+
+    const map<int, step_totals>& steps( ) const { return _steps; }
+
+    string step_report( int step ) const;
+
+    bool write_chrome_trace( const string& file_name ) const;
+
+private:
+
+    struct event
+    {
+        string name;
+        string path;
+        int step;
+        double start;    //us since the profiler was created
+        double duration; //us, < 0 while open
+    };
+
+    struct counter_sample
+    {
+        string name;
+        int step;
+        double time;
+        double value; //running total of the step
+    };
+
+    double now_us( ) const { return chrono::duration<double, micro>( clock::now( ) - _origin ).count( ); }
+
+    bool _enabled = true;
+    int _step = -1;
+    clock::time_point _origin;
+    vector<event> _events;
+    vector<int> _open; //stack of open scopes
+    vector<counter_sample> _samples;
+    map<int, step_totals> _steps;
+};
+
+//times its own lifetime as a child of the enclosing ScopedTimer
+class ScopedTimer
+{
+public:
+
+    ScopedTimer( Profiler& profiler, const string& name ) : _profiler( profiler ), _scope( profiler.open( name ) ) {}
+
+    ~ScopedTimer( ) { _profiler.close( _scope ); }
+
+    ScopedTimer( const ScopedTimer& ) = delete;
+
+    ScopedTimer& operator=( const ScopedTimer& ) = delete;
+
+private:
+
+    Profiler& _profiler;
+    int _scope;
+};
+
+#endif
@@ -30,6 +30,41 @@ int  VisageResultsReader::read_result( string file_to_parse, string keyword, Arr
     return ret_code;
 }
 
+int VisageResultsReader::read_all_results( string file_to_parse, ArrayData &data, map<string, float> *unit_converter, const set<string> *wanted )
+{
+    int total_read = 0;
+    auto is_wanted = [wanted]( const string& keyword ) { return (wanted == NULL) || (wanted->find( keyword ) != wanted->end( )); };
+
+    EclipseXFile xfile( file_to_parse );
+    if(!xfile.is_open( ))
+    {
+        for(auto name_in_file : get_key_names( file_to_parse ))
+        {
+            if(is_wanted( name_in_file ))
+                total_read += (1 - read_result( file_to_parse, name_in_file, data, unit_converter ));
+        }
+        return total_read;
+    }
+
+    for(const string& keyword : xfile.keywords( ))
+    {
+        const EclipseXFile::entry* e = xfile.find( keyword );
+        if(!EclipseXFile::is_numeric( e->type ) || !is_wanted( keyword )) continue;
+
+        float factor = 1.0f;
+        if((unit_converter != NULL) && (unit_converter->find( keyword ) != unit_converter->end( )))
+        {
+            factor = unit_converter->at( keyword );
+        }
+
+        vector<float>& values = data.get_or_create_array( keyword );
+        values.resize( e->count );
+        total_read += xfile.read( keyword, values.data( ), factor ) ? 1 : 0;
+    }
+
+    return total_read;
+}
+
 int VisageResultsReader::read_results( string model_name, string path, int step, const vector<string> &names, ArrayData &data )
 {
     string file_to_parse = get_results_file( model_name, path, step );
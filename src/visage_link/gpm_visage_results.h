@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include <functional>
 #include <fstream>
 #include <filesystem>
@@ -11,6 +12,7 @@ namespace fs = std::experimental::filesystem;
 #include <vector>
 #include "FileSystemUtils.h"
 #include "EclipseReader.h"
+#include "EclipseXFile.h"
 #include "ArrayData.h"
 
 // This process is for demo only
@@ -33,6 +35,10 @@ public:
 
     int  read_result( string file_to_parse, string keyword, ArrayData &data, map<string, float> *unit_converter = NULL, string new_name = "" );
 
+    //maps and indexes the file once, then decodes every array (or only those in wanted) straight into data (unit conversion included).
+    //Falls back to read_result per keyword if the file is not a binary eclipse file. Returns the number of arrays read
+    int  read_all_results( string file_to_parse, ArrayData &data, map<string, float> *unit_converter = NULL, const set<string> *wanted = NULL );
+
     vector<string> get_key_names( string file ) const { return EclipseReader::GetKeywordNames( file ); }
     /*int  read_vertical_deformation(string file_to_parse, ArrayData &data, string new_name = "")
     {return read_result(file_to_parse, "ROCKDISZZ", data, new_name);
@@ -0,0 +1,161 @@
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <algorithm>
+#include <iostream>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <signal.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+#include "gpm_visage_solver_process.h"
+
+VisageSolverProcess::~VisageSolverProcess( )
+{
+    terminate( );
+}
+
+#ifdef WIN32
+
+bool VisageSolverProcess::launch( const string& command )
+{
+    if(_pending) return false;
+
+    string command_line = "cmd /c " + command;
+    STARTUPINFOA si = { sizeof( STARTUPINFOA ) };
+    PROCESS_INFORMATION pi = {};
+    if(!CreateProcessA( NULL, &command_line[0], NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi ))
+        return false;
+
+    CloseHandle( pi.hThread );
+    _process_handle = pi.hProcess;
+    _command = command;
+    _pending = true;
+    return true;
+}
+
+int VisageSolverProcess::wait( double timeout_seconds, bool* timed_out )
+{
+    if(timed_out) *timed_out = false;
+    if(!_pending) return -1;
+
+    DWORD ms = timeout_seconds < 0.0 ? INFINITE : (DWORD)(timeout_seconds * 1000.0);
+    if(WaitForSingleObject( _process_handle, ms ) != WAIT_OBJECT_0)
+    {
+        if(timed_out) *timed_out = true;
+        terminate( );
+        return -1;
+    }
+
+    DWORD code = 0;
+    GetExitCodeProcess( _process_handle, &code );
+    CloseHandle( _process_handle );
+    _process_handle = nullptr;
+    _pending = false;
+    return (int)code;
+}
+
+void VisageSolverProcess::terminate( )
+{
+    if(!_pending) return;
+    TerminateProcess( _process_handle, 1 );
+    WaitForSingleObject( _process_handle, INFINITE );
+    CloseHandle( _process_handle );
+    _process_handle = nullptr;
+    _pending = false;
+}
+
+#else
+
+bool VisageSolverProcess::launch( const string& command )
+{
+    if(_pending) return false;
+
+    //own process group, so terminate( ) also reaches whatever the shell starts (eclrun -> visage)
+    posix_spawnattr_t attr;
+    posix_spawnattr_init( &attr );
+    posix_spawnattr_setflags( &attr, POSIX_SPAWN_SETPGROUP );
+    posix_spawnattr_setpgroup( &attr, 0 );
+
+    const char* argv[] = { "/bin/sh", "-c", command.c_str( ), nullptr };
+    pid_t pid;
+    int ret = posix_spawn( &pid, "/bin/sh", nullptr, &attr, const_cast<char* const*>(argv), environ );
+    posix_spawnattr_destroy( &attr );
+    if(ret != 0) return false;
+
+    _pid = pid;
+    _command = command;
+    _pending = true;
+    return true;
+}
+
+int VisageSolverProcess::wait( double timeout_seconds, bool* timed_out )
+{
+    if(timed_out) *timed_out = false;
+    if(!_pending) return -1;
+
+    int status = 0;
+    if(timeout_seconds < 0.0)
+    {
+        while(waitpid( _pid, &status, 0 ) < 0)
+        {
+            if(errno != EINTR) { _pending = false; return -1; }
+        }
+    }
+    else
+    {
+        //poll, backing off from 1 to 100 ms: solver runs are minutes long, the exit is picked up quickly enough
+        auto deadline = std::chrono::steady_clock::now( ) + std::chrono::duration<double>( timeout_seconds );
+        std::chrono::milliseconds pause( 1 );
+        while(true)
+        {
+            pid_t ret = waitpid( _pid, &status, WNOHANG );
+            if(ret == _pid) break;
+            if(ret < 0 && errno != EINTR) { _pending = false; return -1; }
+            if(std::chrono::steady_clock::now( ) >= deadline)
+            {
+                if(timed_out) *timed_out = true;
+                terminate( );
+                return -1;
+            }
+            std::this_thread::sleep_for( pause );
+            pause = std::min( pause * 2, std::chrono::milliseconds( 100 ) );
+        }
+    }
+
+    _pending = false;
+    return WIFEXITED( status ) ? WEXITSTATUS( status ) : -1;
+}
+
+void VisageSolverProcess::terminate( )
+{
+    if(!_pending) return;
+    kill( -_pid, SIGTERM );
+
+    //a solver that ignores SIGTERM must not hang the host: SIGKILL after the grace period
+    auto deadline = std::chrono::steady_clock::now( ) + std::chrono::duration<double>( terminate_grace_seconds );
+    std::chrono::milliseconds pause( 1 );
+    int status = 0;
+    while(true)
+    {
+        pid_t ret = waitpid( _pid, &status, WNOHANG );
+        if(ret == _pid) break;
+        if(ret < 0 && errno != EINTR) break;
+        if(std::chrono::steady_clock::now( ) >= deadline)
+        {
+            kill( -_pid, SIGKILL );
+            while(waitpid( _pid, &status, 0 ) < 0 && errno == EINTR) {}
+            break;
+        }
+        std::this_thread::sleep_for( pause );
+        pause = std::min( pause * 2, std::chrono::milliseconds( 100 ) );
+    }
+    _pending = false;
+}
+
+#endif
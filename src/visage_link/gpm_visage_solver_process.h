@@ -0,0 +1,51 @@
+#ifndef _VISAGE_SOLVER_PROCESS_H_
+#define _VISAGE_SOLVER_PROCESS_H_ 1
+
+#include <string>
+
+using namespace std;
+
+//A solver run as a child process that is not waited for at launch.
+//The command goes through the shell (/bin/sh -c or cmd /c), same as system( ) did.
+class VisageSolverProcess
+{
+public:
+
+    VisageSolverProcess( ) = default;
+
+    ~VisageSolverProcess( );
+
+    VisageSolverProcess( const VisageSolverProcess& ) = delete;
+
+    VisageSolverProcess& operator=( const VisageSolverProcess& ) = delete;
+
+    //starts the command and returns at once. false if it could not be started or another run is still pending
+    bool launch( const string& command );
+
+    //a launched process that has not been waited for yet
+    bool pending( ) const { return _pending; }
+
+    //blocks until the process exits or timeout_seconds elapse (< 0 waits forever). On timeout the process is killed.
+    //Returns the exit code, or -1 if it timed out or could not be waited for
+    int wait( double timeout_seconds = -1.0, bool* timed_out = nullptr );
+
+    //kills a pending process: SIGTERM to its process group, SIGKILL if it is still there after terminate_grace_seconds
+    void terminate( );
+
+    static constexpr double terminate_grace_seconds = 5.0;
+
+    const string& command( ) const { return _command; }
+
+private:
+
+    string _command;
+    bool _pending = false;
+
+#ifdef WIN32
+    void* _process_handle = nullptr;
+#else
+    int _pid = -1;
+#endif
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include <cmath>
+#include <algorithm>
+
+#include "gpm_visage_warm_start.h"
+
+const vector<pair<string, string>>& WarmStart::stress_names( )
+{
+    static const vector<pair<string, string>> names = {
+        { "STRESSXX", "INITSTRESSXX" }, { "STRESSYY", "INITSTRESSYY" }, { "STRESSZZ", "INITSTRESSZZ" },
+        { "STRESSXY", "INITSTRESSXY" }, { "STRESSYZ", "INITSTRESSYZ" }, { "STRESSZX", "INITSTRESSZX" } };
+    return names;
+}
+
+bool WarmStart::prepare( ArrayData& data, StructuredGrid& geometry, const GridTransfer& transfer, int first_new_layer, string& error )
+{
+    const int ncols = transfer.ncols( ), nrows = transfer.nrows( ), nsurfaces = transfer.nsurfaces( );
+    const int necols = ncols - 1, nerows = nrows - 1, nelayers = nsurfaces - 1;
+    const size_t exy = (size_t)necols * nerows, total_elements = transfer.total_elements( );
+    const size_t old_elements = (size_t)first_new_layer * exy;
+
+    if(first_new_layer < 1 || first_new_layer > nelayers)
+    {
+        error += "\n[WarmStart] no solved layers to start from";
+        return false;
+    }
+    for(const auto& [result, initial] : stress_names( ))
+    {
+        if(!data.contains( result ) || data.array_size( result ) < old_elements)
+        {
+            error += "\n[WarmStart] " + result + " was not read at the last solve";
+            return false;
+        }
+    }
+    if(!data.contains( "DENSITY" ) || data.array_size( "DENSITY" ) != total_elements)
+    {
+        error += "\n[WarmStart] DENSITY not available for the new layers";
+        return false;
+    }
+
+    //outputs sized before the input pointers are taken (address contract: see ArrayStore.h)
+    vector<float*> init;
+    for(const auto& [result, initial] : stress_names( ))
+    {
+        vector<float>& values = data.get_or_create_array( initial );
+        values.resize( total_elements );
+        init.push_back( values.data( ) );
+    }
+
+    //the old layers: the last equilibrium
+    for(size_t c = 0; c < init.size( ); c++)
+    {
+        const vector<float>& last = data.get_array( stress_names( )[c].first );
+        copy( last.begin( ), last.begin( ) + old_elements, init[c] );
+    }
+
+    //the new layers: lithostatic, from the top down, per column
+    const vector<float>& density = data.get_array( "DENSITY" );
+    const float* last_xx = data.get_array( "STRESSXX" ).data( );
+    const float* last_yy = data.get_array( "STRESSYY" ).data( );
+    const float* last_zz = data.get_array( "STRESSZZ" ).data( );
+
+    for(int j = 0; j < nerows; j++)
+    {
+        for(int i = 0; i < necols; i++)
+        {
+            //the old top element of the column gives the horizontal/vertical ratios and the sign
+            size_t below = (size_t)(first_new_layer - 1) * exy + (size_t)j * necols + i;
+            float szz = last_zz[below];
+            float kx = fabsf( szz ) > 1.0e-12f ? last_xx[below] / szz : 1.0f;
+            float ky = fabsf( szz ) > 1.0e-12f ? last_yy[below] / szz : 1.0f;
+            float sign = szz < 0.0f ? -1.0f : 1.0f;
+
+            float overburden = 0.0f;
+            for(int k = nelayers - 1; k >= first_new_layer; k--)
+            {
+                auto column_height = [&]( int surface )
+                {
+                    auto [h, h_end] = geometry.surface_range( surface );
+                    size_t n = (size_t)j * ncols + i;
+                    return 0.25f * (h[n] + h[n + 1] + h[n + ncols] + h[n + ncols + 1]);
+                };
+                size_t e = (size_t)k * exy + (size_t)j * necols + i;
+                float half_load = 0.5f * density_to_stress_gradient * density[e] * fabsf( column_height( k + 1 ) - column_height( k ) );
+
+                overburden += half_load;
+                float vertical = sign * overburden;
+                init[0][e] = kx * vertical;
+                init[1][e] = ky * vertical;
+                init[2][e] = vertical;
+                init[3][e] = init[4][e] = init[5][e] = 0.0f;
+                overburden += half_load;
+            }
+        }
+    }
+
+    return true;
+}
+
+void WarmStart::cold( ArrayData& data, size_t total_elements )
+{
+    for(const auto& [result, initial] : stress_names( ))
+    {
+        if(!data.contains( initial )) continue;
+        vector<float>& values = data.get_array( initial );
+        values.assign( total_elements, 0.0f );
+    }
+}
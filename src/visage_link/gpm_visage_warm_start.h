@@ -0,0 +1,38 @@
+#ifndef _VISAGE_WARM_START_H_
+#define _VISAGE_WARM_START_H_ 1
+
+#include <string>
+#include <vector>
+
+#include "ArrayData.h"
+#include "StructuredGrid.h"
+#include "GridTransfer.h"
+
+using namespace std;
+
+//Initial stresses for the next solve, so that the solver starts from the last equilibrium instead of
+//from zero. The element layers that existed at the last step keep the stresses read back from it; the new
+//layers get a lithostatic state: vertical stress from the overburden of the new layers (DENSITY * g * thickness),
+//horizontal stresses with the sxx/szz and syy/szz ratios of the old top element of the same column (sign
+//convention of the results included), no shear.
+//Displacements are not carried over: every step they are applied to the geometry, so the next solve starts
+//from zero displacement on the updated mesh.
+class WarmStart
+{
+public:
+
+    //result array -> initial condition array (exported with the other data arrays to the deck or the worker)
+    static const vector<pair<string, string>>& stress_names( );
+
+    //first_new_layer: element layers [0, first_new_layer) existed at the last solve.
+    //false (and no arrays written) when there is nothing to start from (first step, results not read)
+    static bool prepare( ArrayData& data, StructuredGrid& geometry, const GridTransfer& transfer, int first_new_layer, string& error );
+
+    //zero initial stresses (a cold start) in the initial condition arrays that exist, sized to the model
+    static void cold( ArrayData& data, size_t total_elements );
+
+    //DENSITY is in gr/cm3, stresses in MPa: MPa per metre per gr/cm3 (g = 10, as the unit conversion to visage)
+    static constexpr float density_to_stress_gradient = 0.01f;
+};
+
+#endif
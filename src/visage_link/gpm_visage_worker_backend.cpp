@@ -0,0 +1,349 @@
+#include <iostream>
+#include <algorithm>
+#include <fstream>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+
+#ifndef WIN32
+#include <spawn.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+#include "gpm_visage_worker_backend.h"
+
+namespace {
+    //geometry heights ("ZCOORD", copied into heights) followed by every array in data
+    vector<WorkerArrayView> model_views( StructuredGrid& geometry, ArrayData& data, vector<float>& heights, WorkerModelDescription& model )
+    {
+        auto [ncols, nrows, nsurfaces, total_nodes, total_elements] = geometry.get_geometry_description( );
+        model.ncols = ncols;
+        model.nrows = nrows;
+        model.nsurfaces = nsurfaces;
+
+        const size_t nxy = (size_t)ncols * nrows;
+        heights.resize( nxy * nsurfaces );
+        for(int k = 0; k < nsurfaces; k++)
+        {
+            auto [it1, it2] = geometry.surface_range( k );
+            copy( it1, it2, heights.begin( ) + k * nxy );
+        }
+
+        vector<WorkerArrayView> arrays = { { WorkerProtocol::geometry_array, heights.data( ), heights.size( ) } };
+        for(const string& name : data.array_names( ))
+        {
+            if(name.size( ) > WorkerProtocol::max_name_length) continue;
+            vector<float>& values = data.get_array( name );
+            arrays.push_back( { name, values.data( ), values.size( ) } );
+        }
+        return arrays;
+    }
+
+    //to solver units, in place in a written segment
+    void convert_units( void* mem, size_t size, map<string, float>* unit_converter )
+    {
+        if(unit_converter == NULL) return;
+
+        WorkerModelDescription model;
+        read_worker_segment( mem, size, model, [unit_converter]( const string& name, const float* values, size_t count )
+                             {
+                                 auto it = unit_converter->find( name );
+                                 if(it == unit_converter->end( )) return;
+                                 float* v = const_cast<float*>(values);
+                                 for(size_t n = 0; n < count; n++) v[n] *= it->second;
+                             } );
+    }
+}
+
+bool VisageWorkerBackend::write_snapshot_file( const string& file_name, int step, StructuredGrid& geometry, ArrayData& data, map<string, float>* unit_converter, string& error )
+{
+    vector<float> heights;
+    WorkerModelDescription model;
+    vector<WorkerArrayView> arrays = model_views( geometry, data, heights, model );
+    model.step = step;
+
+    vector<char> buffer( worker_segment_size( arrays ) );
+    write_worker_segment( buffer.data( ), model, arrays );
+    convert_units( buffer.data( ), buffer.size( ), unit_converter );
+
+    ofstream out( file_name, ios::binary );
+    out.write( buffer.data( ), buffer.size( ) );
+    if(!out)
+    {
+        error += "\n[VisageWorkerBackend] cannot write model snapshot " + file_name;
+        return false;
+    }
+    return true;
+}
+
+#ifndef WIN32
+
+bool VisageWorkerBackend::start( const string& command, string& error )
+{
+    if(running( )) return true;
+
+    //one bidirectional channel: the worker reads commands on stdin and replies on stdout
+    int fds[2];
+    if(socketpair( AF_UNIX, SOCK_STREAM, 0, fds ) != 0)
+    {
+        error += "\n[VisageWorkerBackend] cannot create the control channel";
+        return false;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init( &actions );
+    posix_spawn_file_actions_adddup2( &actions, fds[1], 0 );
+    posix_spawn_file_actions_adddup2( &actions, fds[1], 1 );
+    posix_spawn_file_actions_addclose( &actions, fds[0] );
+    posix_spawn_file_actions_addclose( &actions, fds[1] );
+
+    //own process group, so a kill also reaches whatever the shell starts
+    posix_spawnattr_t attr;
+    posix_spawnattr_init( &attr );
+    posix_spawnattr_setflags( &attr, POSIX_SPAWN_SETPGROUP );
+    posix_spawnattr_setpgroup( &attr, 0 );
+
+    const char* argv[] = { "/bin/sh", "-c", command.c_str( ), nullptr };
+    pid_t pid;
+    int ret = posix_spawn( &pid, "/bin/sh", &actions, &attr, const_cast<char* const*>(argv), environ );
+    posix_spawn_file_actions_destroy( &actions );
+    posix_spawnattr_destroy( &attr );
+    close( fds[1] );
+
+    if(ret != 0)
+    {
+        close( fds[0] );
+        error += "\n[VisageWorkerBackend] cannot start worker: " + command;
+        return false;
+    }
+
+    _pid = pid;
+    _channel = fds[0];
+    _read_buffer.clear( );
+    cout << "[VisageWorkerBackend] started worker " << command << " pid " << _pid << endl;
+    return true;
+}
+
+bool VisageWorkerBackend::running( )
+{
+    if(_pid <= 0) return false;
+
+    int status = 0;
+    if(waitpid( _pid, &status, WNOHANG ) == 0) return true;
+    report_exit( status );
+    release( );
+    return false;
+}
+
+void VisageWorkerBackend::report_exit( int status ) const
+{
+    if(WIFSIGNALED( status ))
+        cout << "[VisageWorkerBackend] worker pid " << _pid << " killed by signal " << WTERMSIG( status ) << endl;
+    else
+        cout << "[VisageWorkerBackend] worker pid " << _pid << " exited with status " << WEXITSTATUS( status ) << endl;
+}
+
+void VisageWorkerBackend::release( )
+{
+    close( _channel );
+    _pid = -1;
+    _channel = -1;
+    _pending = false;
+    _read_buffer.clear( );
+}
+
+void VisageWorkerBackend::wait_or_kill( double grace_seconds )
+{
+    //poll, backing off from 1 to 100 ms, then kill the process group: a busy or hung worker does not hold the host
+    auto deadline = std::chrono::steady_clock::now( ) + std::chrono::duration<double>( grace_seconds );
+    std::chrono::milliseconds pause( 1 );
+    int status = 0;
+    while(true)
+    {
+        pid_t ret = waitpid( _pid, &status, WNOHANG );
+        if(ret == _pid) break;
+        if(ret < 0 && errno != EINTR) break;
+        if(std::chrono::steady_clock::now( ) >= deadline)
+        {
+            kill( -_pid, SIGKILL );
+            while(waitpid( _pid, &status, 0 ) < 0 && errno == EINTR) {}
+            break;
+        }
+        std::this_thread::sleep_for( pause );
+        pause = std::min( pause * 2, std::chrono::milliseconds( 100 ) );
+    }
+    report_exit( status );
+    release( );
+}
+
+bool VisageWorkerBackend::send_line( const string& line )
+{
+    string msg = line + "\n";
+    size_t sent = 0;
+    while(sent < msg.size( ))
+    {
+        ssize_t n = send( _channel, msg.data( ) + sent, msg.size( ) - sent, MSG_NOSIGNAL );
+        if(n < 0)
+        {
+            if(errno == EINTR) continue;
+            return false;
+        }
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+bool VisageWorkerBackend::read_line( string& line, double timeout_seconds )
+{
+    size_t eol;
+    while((eol = _read_buffer.find( '\n' )) == string::npos)
+    {
+        pollfd pfd = { _channel, POLLIN, 0 };
+        int ret = poll( &pfd, 1, timeout_seconds < 0.0 ? -1 : (int)(timeout_seconds * 1000.0) );
+        if(ret < 0 && errno == EINTR) continue;
+        if(ret <= 0) return false;
+
+        char buffer[256];
+        ssize_t n = recv( _channel, buffer, sizeof( buffer ), 0 );
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) return false; //worker gone
+        _read_buffer.append( buffer, (size_t)n );
+    }
+
+    line = _read_buffer.substr( 0, eol );
+    _read_buffer.erase( 0, eol + 1 );
+    return true;
+}
+
+bool VisageWorkerBackend::submit_step( int step, StructuredGrid& geometry, ArrayData& data, map<string, float>* unit_converter, string& error )
+{
+    if(!running( ) || _pending)
+    {
+        error += "\n[VisageWorkerBackend] worker not running or previous step not collected";
+        return false;
+    }
+
+    WorkerModelDescription model;
+    vector<float>& heights = _scratch->get( geometry.total_nodes( ) );
+    vector<WorkerArrayView> arrays = model_views( geometry, data, heights, model );
+    model.step = step;
+
+    //the input segment is reused across steps, it only grows
+    size_t bytes = worker_segment_size( arrays );
+    if(_input.data( ) == nullptr || _input.size( ) < bytes)
+    {
+        string name = "/gpm_vs_" + to_string( getpid( ) ) + "_in";
+        if(!_input.create( name, bytes ))
+        {
+            error += "\n[VisageWorkerBackend] cannot create shared memory segment " + name;
+            return false;
+        }
+    }
+
+    write_worker_segment( _input.data( ), model, arrays );
+    convert_units( _input.data( ), _input.size( ), unit_converter );
+
+    if(!send_line( "STEP " + _input.name( ) ))
+    {
+        error += "\n[VisageWorkerBackend] worker is not listening";
+        return false;
+    }
+
+    _pending = true;
+    return true;
+}
+
+int VisageWorkerBackend::collect_step( ArrayData& data, map<string, float>* unit_converter, const set<string>* wanted, double timeout_seconds, string& error )
+{
+    if(!_pending)
+    {
+        error += "\n[VisageWorkerBackend] no step was submitted";
+        return -1;
+    }
+    _pending = false;
+
+    //on a timeout or a bad reply the worker is stopped: a late reply would otherwise answer the next step
+    string reply;
+    if(!read_line( reply, timeout_seconds ))
+    {
+        error += running( ) ? "\n[VisageWorkerBackend] no reply from worker (timed out), worker stopped" : "\n[VisageWorkerBackend] worker exited during the step";
+        stop( );
+        return -1;
+    }
+
+    if(reply.compare( 0, 5, "DONE " ) != 0)
+    {
+        error += "\n[VisageWorkerBackend] worker failed: " + reply + ", worker stopped";
+        stop( );
+        return -1;
+    }
+
+    //the worker owns the output segment, we only map it for the copy
+    if(!_output.open( reply.substr( 5 ) ))
+    {
+        error += "\n[VisageWorkerBackend] cannot open results segment " + reply.substr( 5 );
+        return -1;
+    }
+
+    int total_read = 0;
+    WorkerModelDescription model;
+    bool ok = read_worker_segment( _output.data( ), _output.size( ), model, [&]( const string& name, const float* values, size_t count )
+                                   {
+                                       if(wanted != NULL && wanted->find( name ) == wanted->end( )) return;
+                                       float factor = 1.0f;
+                                       if(unit_converter != NULL && unit_converter->find( name ) != unit_converter->end( ))
+                                           factor = unit_converter->at( name );
+
+                                       vector<float>& dst = data.get_or_create_array( name );
+                                       dst.resize( count );
+                                       for(size_t n = 0; n < count; n++) dst[n] = factor * values[n];
+                                       total_read += 1;
+                                   } );
+    _output.close( );
+
+    if(!ok)
+    {
+        error += "\n[VisageWorkerBackend] malformed results segment";
+        return -1;
+    }
+    return total_read;
+}
+
+void VisageWorkerBackend::stop( )
+{
+    if(running( ))
+    {
+        send_line( "QUIT" );
+        ::shutdown( _channel, SHUT_WR ); //EOF for workers that read until the end of their input
+        wait_or_kill( quit_grace_seconds );
+    }
+
+    _input.unlink( );
+    _input.close( );
+}
+
+#else
+
+bool VisageWorkerBackend::start( const string& command, string& error )
+{
+    error += "\n[VisageWorkerBackend] the solver worker is not available on windows";
+    return false;
+}
+
+bool VisageWorkerBackend::running( ) { return false; }
+
+bool VisageWorkerBackend::send_line( const string& line ) { return false; }
+
+bool VisageWorkerBackend::read_line( string& line, double timeout_seconds ) { return false; }
+
+bool VisageWorkerBackend::submit_step( int step, StructuredGrid& geometry, ArrayData& data, map<string, float>* unit_converter, string& error ) { return false; }
+
+int VisageWorkerBackend::collect_step( ArrayData& data, map<string, float>* unit_converter, const set<string>* wanted, double timeout_seconds, string& error ) { return -1; }
+
+void VisageWorkerBackend::stop( ) {}
+
+#endif
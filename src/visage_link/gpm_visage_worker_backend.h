@@ -0,0 +1,83 @@
+#ifndef _VISAGE_WORKER_BACKEND_H_
+#define _VISAGE_WORKER_BACKEND_H_ 1
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+
+#include "ArrayData.h"
+#include "StructuredGrid.h"
+#include "ScratchPool.h"
+#include "gpm_visage_worker_protocol.h"
+
+using namespace std;
+
+//Coupler side of the persistent solver worker (see gpm_visage_worker_protocol.h).
+//The worker is started once and kept alive across steps; every step the geometry and the
+//property arrays go through shared memory instead of a deck on disk, and the results come back the same way.
+//POSIX only: on windows start( ) fails and the coupler keeps using eclrun.
+class VisageWorkerBackend
+{
+public:
+
+    VisageWorkerBackend( ) = default;
+
+    ~VisageWorkerBackend( ) { stop( ); }
+
+    VisageWorkerBackend( const VisageWorkerBackend& ) = delete;
+
+    VisageWorkerBackend& operator=( const VisageWorkerBackend& ) = delete;
+
+    //starts "/bin/sh -c command" with its stdin/stdout connected to the control channel
+    bool start( const string& command, string& error );
+
+    //false once the worker has exited. A crashed worker is reaped here, the next start( ) launches a new one
+    bool running( );
+
+    //the per-step scratch buffers (the owner resets them at the end of the step)
+    void use_scratch( shared_ptr<ScratchPool> pool ) { _scratch = pool; }
+
+    //a submitted step whose results have not been collected yet
+    bool pending( ) const { return _pending; }
+
+    //sends geometry + arrays (scaled by unit_converter, i.e. in solver units) and starts the step. Returns at once
+    bool submit_step( int step, StructuredGrid& geometry, ArrayData& data, map<string, float>* unit_converter, string& error );
+
+    //waits up to timeout_seconds (< 0 no limit) for the step and copies the results (the wanted ones if not NULL) into data,
+    //scaled by unit_converter. Returns the number of arrays read, -1 on failure (after a timeout or a bad reply the worker is stopped)
+    int  collect_step( ArrayData& data, map<string, float>* unit_converter, const set<string>* wanted, double timeout_seconds, string& error );
+
+    //QUIT, then waits quit_grace_seconds for the worker (killed after that) and removes the input segment
+    void stop( );
+
+    //the same model a step sends to the worker, written to a file instead (for visage_emulator)
+    static bool write_snapshot_file( const string& file_name, int step, StructuredGrid& geometry, ArrayData& data, map<string, float>* unit_converter, string& error );
+
+private:
+
+    bool send_line( const string& line );
+
+    bool read_line( string& line, double timeout_seconds );
+
+    //waits up to grace_seconds for the worker to exit, then kills its process group. Reaps it either way
+    void wait_or_kill( double grace_seconds );
+
+    void report_exit( int status ) const;
+
+    //forgets the reaped worker
+    void release( );
+
+    static constexpr double quit_grace_seconds = 5.0;
+
+    int _pid = -1;
+    int _channel = -1;
+    bool _pending = false;
+    string _read_buffer;
+    SharedMemorySegment _input;
+    SharedMemorySegment _output;
+    shared_ptr<ScratchPool> _scratch = make_shared<ScratchPool>( );
+};
+
+#endif
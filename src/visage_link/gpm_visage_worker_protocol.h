@@ -0,0 +1,217 @@
+#ifndef _VISAGE_WORKER_PROTOCOL_H_
+#define _VISAGE_WORKER_PROTOCOL_H_ 1
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+//Handoff between the coupler and a long-lived solver worker process.
+//
+//Data goes through POSIX shared-memory segments laid out as
+//    [WorkerSegmentHeader][WorkerArrayEntry x num_arrays][float data...]
+//The geometry is sent as the nodal array "ZCOORD" (nsurfaces * nrows * ncols heights, col fastest).
+//
+//Control goes through the worker's stdin/stdout, one line per message:
+//    coupler -> worker   STEP <input segment name>
+//    worker  -> coupler  DONE <output segment name>     or    ERROR <message>
+//    coupler -> worker   QUIT
+//The coupler owns the input segment, the worker owns the output segment; each side unlinks its own.
+
+using namespace std;
+
+namespace WorkerProtocol
+{
+    const uint32_t magic = 0x53565047; //"GPVS"
+    const uint32_t version = 1;
+    const size_t max_name_length = 31;
+    const string geometry_array = "ZCOORD";
+}
+
+struct WorkerSegmentHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t step;
+    int32_t ncols, nrows, nsurfaces;
+    uint32_t num_arrays;
+    uint32_t reserved;
+    uint64_t total_bytes;
+};
+
+struct WorkerArrayEntry
+{
+    char name[WorkerProtocol::max_name_length + 1];
+    uint64_t count;
+    uint64_t offset; //from the start of the segment, in bytes
+};
+
+//a named float array that is serialized without an intermediate copy
+struct WorkerArrayView
+{
+    string name;
+    const float* data;
+    size_t count;
+};
+
+struct WorkerModelDescription
+{
+    int step = 0;
+    int ncols = 0, nrows = 0, nsurfaces = 0;
+};
+
+inline size_t worker_segment_size( const vector<WorkerArrayView>& arrays )
+{
+    size_t bytes = sizeof( WorkerSegmentHeader ) + arrays.size( ) * sizeof( WorkerArrayEntry );
+    for(const auto& a : arrays) bytes += a.count * sizeof( float );
+    return bytes;
+}
+
+//mem must hold worker_segment_size( arrays ) bytes
+inline void write_worker_segment( void* mem, const WorkerModelDescription& model, const vector<WorkerArrayView>& arrays )
+{
+    auto* header = static_cast<WorkerSegmentHeader*>(mem);
+    header->magic = WorkerProtocol::magic;
+    header->version = WorkerProtocol::version;
+    header->step = model.step;
+    header->ncols = model.ncols;
+    header->nrows = model.nrows;
+    header->nsurfaces = model.nsurfaces;
+    header->num_arrays = (uint32_t)arrays.size( );
+    header->reserved = 0;
+    header->total_bytes = worker_segment_size( arrays );
+
+    auto* entries = reinterpret_cast<WorkerArrayEntry*>(header + 1);
+    size_t offset = sizeof( WorkerSegmentHeader ) + arrays.size( ) * sizeof( WorkerArrayEntry );
+    for(size_t n = 0; n < arrays.size( ); n++)
+    {
+        memset( entries[n].name, 0, sizeof( entries[n].name ) );
+        strncpy( entries[n].name, arrays[n].name.c_str( ), WorkerProtocol::max_name_length );
+        entries[n].count = arrays[n].count;
+        entries[n].offset = offset;
+        if(arrays[n].count > 0)
+            memcpy( static_cast<char*>(mem) + offset, arrays[n].data, arrays[n].count * sizeof( float ) );
+        offset += arrays[n].count * sizeof( float );
+    }
+}
+
+//validates the segment and calls on_array( name, data, count ) for each array, pointing into the segment. False if malformed
+inline bool read_worker_segment( const void* mem, size_t size, WorkerModelDescription& model, const function<void( const string&, const float*, size_t )>& on_array )
+{
+    if(size < sizeof( WorkerSegmentHeader )) return false;
+    const auto* header = static_cast<const WorkerSegmentHeader*>(mem);
+    if(header->magic != WorkerProtocol::magic || header->version != WorkerProtocol::version || header->total_bytes > size) return false;
+    if(sizeof( WorkerSegmentHeader ) + header->num_arrays * sizeof( WorkerArrayEntry ) > size) return false;
+
+    model.step = header->step;
+    model.ncols = header->ncols;
+    model.nrows = header->nrows;
+    model.nsurfaces = header->nsurfaces;
+
+    const auto* entries = reinterpret_cast<const WorkerArrayEntry*>(header + 1);
+    for(uint32_t n = 0; n < header->num_arrays; n++)
+    {
+        if(entries[n].offset + entries[n].count * sizeof( float ) > header->total_bytes) return false;
+        string name( entries[n].name, strnlen( entries[n].name, sizeof( entries[n].name ) ) );
+        on_array( name, reinterpret_cast<const float*>(static_cast<const char*>(mem) + entries[n].offset), (size_t)entries[n].count );
+    }
+    return true;
+}
+
+//A named POSIX shared-memory segment mapped read/write. Not available on windows builds
+class SharedMemorySegment
+{
+public:
+
+    SharedMemorySegment( ) = default;
+
+    ~SharedMemorySegment( ) { close( ); }
+
+    SharedMemorySegment( const SharedMemorySegment& ) = delete;
+
+    SharedMemorySegment& operator=( const SharedMemorySegment& ) = delete;
+
+    //creates (or recreates, if it exists) and maps size bytes
+    bool create( const string& name, size_t size )
+    {
+        close( );
+#ifndef WIN32
+        int fd = shm_open( name.c_str( ), O_CREAT | O_RDWR, 0600 );
+        if(fd < 0) return false;
+        bool ok = ftruncate( fd, (off_t)size ) == 0 && map( fd, size );
+        ::close( fd );
+        if(ok) _name = name;
+        return ok;
+#else
+        return false;
+#endif
+    }
+
+    //maps an existing segment, whole
+    bool open( const string& name )
+    {
+        close( );
+#ifndef WIN32
+        int fd = shm_open( name.c_str( ), O_RDWR, 0600 );
+        if(fd < 0) return false;
+        struct stat st;
+        bool ok = fstat( fd, &st ) == 0 && st.st_size > 0 && map( fd, (size_t)st.st_size );
+        ::close( fd );
+        if(ok) _name = name;
+        return ok;
+#else
+        return false;
+#endif
+    }
+
+    void close( )
+    {
+#ifndef WIN32
+        if(_data) munmap( _data, _size );
+#endif
+        _data = nullptr;
+        _size = 0;
+    }
+
+    //removes the name; the memory goes away once every side has unmapped it
+    void unlink( )
+    {
+#ifndef WIN32
+        if(!_name.empty( )) shm_unlink( _name.c_str( ) );
+#endif
+        _name.clear( );
+    }
+
+    void* data( ) const { return _data; }
+
+    size_t size( ) const { return _size; }
+
+    const string& name( ) const { return _name; }
+
+private:
+
+#ifndef WIN32
+    bool map( int fd, size_t size )
+    {
+        void* ptr = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+        if(ptr == MAP_FAILED) return false;
+        _data = ptr;
+        _size = size;
+        return true;
+    }
+#endif
+
+    string _name;
+    void* _data = nullptr;
+    size_t _size = 0;
+};
+
+#endif
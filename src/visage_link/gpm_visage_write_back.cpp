@@ -0,0 +1,86 @@
+#include "utils.h"
+#include "gpm_visage_write_back.h"
+
+void WriteBackPlan::set_outputs( const vector<string>& names )
+{
+    if(names == _names) return;
+
+    _names = names;
+    _outputs.clear( );
+    for(const string& name : names) _outputs.push_back( { _arrays.intern( name ), display_scale( name ) } );
+}
+
+float WriteBackPlan::display_scale( const string& name )
+{
+    float scale = 1.0f;
+    if((name.find( "STRAIN" ) != string::npos) || (name.find( "STRN" ) != string::npos)) scale *= 1.0e5f;
+    if(name.find( "EFFSTR" ) != string::npos) scale *= 1.0e5f;
+    return scale;
+}
+
+int WriteBackPlan::write( ArrayData& data, const GridTransfer& transfer, attr_lookup_type& attributes, string& error )
+{
+    _arrays.bind( data );
+
+    //one task per surface of every output that can be written
+    struct task
+    {
+        const float* values;
+        bool elemental;
+        float scale;
+        gpm_attribute* target;
+    };
+
+    const int nsurfaces = transfer.nsurfaces( );
+    const size_t nodes = transfer.total_nodes( ), elements = transfer.total_elements( );
+    vector<task> tasks;
+    int written = 0;
+    for(const output& o : _outputs)
+    {
+        if(!_arrays.contains( o.array )) continue;
+        const vector<float>& values = _arrays[o.array];
+        if(values.empty( ) || (values.size( ) != nodes && values.size( ) != elements)) continue; //not computed, etc...
+
+        auto it = attributes.find( _arrays.name( o.array ) );
+        if(it == attributes.end( )) continue;
+        gpm_attribute& to_gpm = it->second;
+        if((int)to_gpm.size( ) < nsurfaces)
+        {
+            error += "\n[WriteBackPlan] attribute " + _arrays.name( o.array ) + " has fewer surfaces than the geometry";
+            continue;
+        }
+
+        tasks.push_back( { values.data( ), values.size( ) == elements, o.scale, &to_gpm } );
+        written += 1;
+    }
+
+    const size_t nxy = (size_t)transfer.ncols( ) * transfer.nrows( );
+    const int ntasks = (int)tasks.size( ) * nsurfaces;
+    _scratch.prepare( _max_threads );
+    parallel_chunks( ntasks, ntasks * nxy, [&, nxy, nsurfaces]( int first, int last, int chunk )
+                     {
+                         vector<float>& scratch = _scratch.get( chunk, transfer.surface_scratch_size( ) );
+                         for(int t = first; t < last; t++)
+                         {
+                             const task& tk = tasks[t / nsurfaces];
+                             int k = t % nsurfaces;
+                             auto& surface = (*tk.target)[k];
+                             float* out = &surface( 0, 0 );
+                             const ptrdiff_t rs = surface.stride[0], cs = surface.stride[1];
+
+                             if(tk.elemental)
+                             {
+                                 transfer.surface_to_nodes( tk.values, k, tk.scale, out, rs, cs, scratch );
+                             }
+                             else
+                             {
+                                 //nodal arrays are displayed as they are
+                                 const float* in = tk.values + k * nxy;
+                                 for(int j = 0; j < transfer.nrows( ); j++)
+                                     for(int i = 0; i < transfer.ncols( ); i++) out[j * rs + i * cs] = in[(size_t)j * transfer.ncols( ) + i];
+                             }
+                         }
+                     }, _max_threads );
+
+    return written;
+}
@@ -0,0 +1,53 @@
+#ifndef _VISAGE_WRITE_BACK_H_
+#define _VISAGE_WRITE_BACK_H_ 1
+
+#include <string>
+#include <vector>
+
+#include "ArrayData.h"
+#include "AttributeIterator.h"
+#include "ArrayStore.h"
+#include "GridTransfer.h"
+
+using namespace std;
+
+//Copies the display arrays back to the gpm attributes at the end of a step.
+//The outputs (array, display scale) are resolved once per output list. Every step, one task per
+//(output, surface) averages the elements around the nodes of that surface, scales them and writes
+//them straight into the gpm surface through its row/column strides. The tasks run over threads.
+class WriteBackPlan
+{
+public:
+
+    //no-op if the names did not change
+    void set_outputs( const vector<string>& names );
+
+    //outputs whose array has as many values as nodes are copied as they are, element arrays are averaged
+    //to nodes and scaled; anything else (not computed, constants) is skipped. Returns the outputs written
+    int  write( ArrayData& data, const GridTransfer& transfer, attr_lookup_type& attributes, string& error );
+
+    //the attribute names of the last set_outputs
+    const vector<string>& outputs( ) const { return _names; }
+
+    //the factor applied to an element array before display (strains and effective stresses: 1e5)
+    static float display_scale( const string& name );
+
+    //limit the number of threads (0: hardware concurrency)
+    int& max_threads( ) { return _max_threads; }
+
+private:
+
+    struct output
+    {
+        ArrayStore::handle array;
+        float scale;
+    };
+
+    vector<string> _names;
+    vector<output> _outputs;
+    ArrayStore _arrays;
+    int _max_threads = 0;
+    ChunkBuffers _scratch; //surface_to_nodes scratch, one per chunk of tasks
+};
+
+#endif
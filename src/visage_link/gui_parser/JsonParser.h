@@ -14,6 +14,7 @@
 #include "UIParamerers.h"
 #include "Table.h"
 #include "VisageDeckSimulationOptions.h"
+#include "gpm_visage_derived_results.h"
 
 
 #pragma warning(push, 0)
@@ -90,7 +91,7 @@ public:
             {
                 bool  value = itr->value.GetBool( );
                 istringstream stream( name );
-                std::for_each( istream_iterator<string>( stream ), istream_iterator<string>( ), [value, &results_keywords, &output_array_names, &visageOptions]( string word )
+                std::for_each( istream_iterator<string>( stream ), istream_iterator<string>( ), [value, &results_keywords, &output_array_names, &visageOptions, &ui_params]( string word )
                                {
                                    if(word == "enforce_elastic")
                                    {
@@ -100,7 +101,12 @@ public:
                                    {
                                        visageOptions.auto_config_plasticity( ) = !value;
                                    }
-                                   else if(find( results_keywords.begin( ), results_keywords.end( ), word ) != results_keywords.end( ))
+                                   else if(word == "async_solver" || word == "profile" || word == "count_allocations" || word == "warm_start" || word == "remove_pinchouts")
+                                   {
+                                       ui_params.flags[word] = value;
+                                   }
+                                   else if(find( results_keywords.begin( ), results_keywords.end( ), word ) != results_keywords.end( ) ||
+                                           DerivedResults::builtin_names( ).count( word ) > 0)
                                    {
                                        if(value)
                                            output_array_names.insert( word );
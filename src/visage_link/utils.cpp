@@ -11,4 +11,12 @@ bool exact_match ( std::string s, const vector<string> &l )
 {
     for(auto it = l.cbegin( ); it != l.cend( ); it++) if(s == *it) return true;
     return false;
-}
\ No newline at end of file
+}
+
+std::string replace_all( std::string s, const std::string& what, const std::string& with )
+{
+    if(what.empty( )) return s;
+    for(size_t pos = s.find( what ); pos != s.npos; pos = s.find( what, pos + with.size( ) ))
+        s.replace( pos, what.size( ), with );
+    return s;
+}
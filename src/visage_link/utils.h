@@ -6,6 +6,8 @@
 #include <numeric>
 #include <iterator>
 #include <string>
+#include <thread>
+#include <type_traits>
 
 using namespace std;
 
@@ -52,11 +54,72 @@ void forall( Container& c, Function f ) { for_it( c.begin( ), c.end( ), f ); }
 template< class Container, class Function >
 void for_range( Container& c, int n, int n2, Function f ) { for_it( c.begin( ) + n, c.begin( ) + n2, f ); }
 
+//upper bound of the chunks parallel_chunks splits the work in, for the same max_threads
+inline int parallel_max_chunks( int max_threads = 0 )
+{
+    return max_threads > 0 ? max_threads : (int)std::max( 1u, thread::hardware_concurrency( ) );
+}
+
+//runs f( first, last ) over [0, n) in contiguous chunks, one per thread (max_threads 0: hardware concurrency).
+//Below min_work (whatever unit the caller counts) everything runs on the calling thread.
+//f( first, last, chunk ) also gets the chunk, in [0, parallel_max_chunks( max_threads )), e.g. to pick its ChunkBuffers
+template< class Function >
+void parallel_chunks( int n, size_t work, Function f, int max_threads = 0, size_t min_work = 262144 )
+{
+    auto run = [&f]( int first, int last, int chunk )
+    {
+        if constexpr(is_invocable_v<Function&, int, int, int>) f( first, last, chunk );
+        else f( first, last );
+    };
+
+    int nthreads = std::min( parallel_max_chunks( max_threads ), n );
+    if(nthreads <= 1 || work < min_work)
+    {
+        if(n > 0) run( 0, n, 0 );
+        return;
+    }
+
+    vector<thread> threads;
+    int chunk = (n + nthreads - 1) / nthreads;
+    for(int first = chunk; first < n; first += chunk)
+        threads.emplace_back( run, first, std::min( n, first + chunk ), first / chunk );
+    run( 0, std::min( n, chunk ), 0 );
+    for(auto& t : threads) t.join( );
+}
+
+//one float buffer per chunk of parallel_chunks, kept across calls: once they have grown to the model
+//size the chunks allocate nothing. prepare( ) on the calling thread, then every chunk uses its own
+class ChunkBuffers
+{
+public:
+
+    void prepare( int max_threads = 0 )
+    {
+        size_t n = (size_t)parallel_max_chunks( max_threads );
+        if(_buffers.size( ) < n) _buffers.resize( n );
+    }
+
+    //n floats, contents undefined
+    vector<float>& get( int chunk, size_t n )
+    {
+        vector<float>& buffer = _buffers[chunk];
+        buffer.resize( n );
+        return buffer;
+    }
+
+private:
+
+    vector<vector<float>> _buffers;
+};
+
 bool finder( std::string s, std::initializer_list<std::string> l );
 
 
 bool exact_match( std::string s, const vector<string> &l );
 
+//every occurrence of what in s replaced by with
+std::string replace_all( std::string s, const std::string& what, const std::string& with );
+
 #endif
 
  
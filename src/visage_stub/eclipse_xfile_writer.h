@@ -0,0 +1,73 @@
+#ifndef VISAGE_STUB_ECLIPSE_XFILE_WRITER_H_
+#define VISAGE_STUB_ECLIPSE_XFILE_WRITER_H_ 1
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+//Writes REAL arrays as a binary, big-endian eclipse file, the layout the VISAGE X files use:
+//a 16 byte header record (keyword, count, type) followed by data records of at most 1000 values,
+//every record framed by its byte length.
+class EclipseXFileWriter
+{
+public:
+
+    static bool write( const string& file_name, const map<string, vector<float>>& arrays )
+    {
+        ofstream out( file_name, ios::binary );
+        if(!out) return false;
+
+        for(const auto& a : arrays)
+        {
+            char header[16];
+            memset( header, ' ', sizeof( header ) );
+            memcpy( header, a.first.c_str( ), std::min<size_t>( 8, a.first.size( ) ) );
+            put_int32( header + 8, (uint32_t)a.second.size( ) );
+            memcpy( header + 12, "REAL", 4 );
+            write_record( out, header, sizeof( header ) );
+
+            const size_t block = 1000;
+            vector<char> buffer( block * 4 );
+            for(size_t first = 0; first < a.second.size( ); first += block)
+            {
+                size_t n = std::min( block, a.second.size( ) - first );
+                for(size_t i = 0; i < n; i++)
+                {
+                    uint32_t bits;
+                    memcpy( &bits, &a.second[first + i], 4 );
+                    put_int32( &buffer[4 * i], bits );
+                }
+                write_record( out, buffer.data( ), 4 * n );
+            }
+        }
+
+        return (bool)out;
+    }
+
+private:
+
+    static void put_int32( char* dst, uint32_t v )
+    {
+        dst[0] = (char)((v >> 24) & 0xff);
+        dst[1] = (char)((v >> 16) & 0xff);
+        dst[2] = (char)((v >> 8) & 0xff);
+        dst[3] = (char)(v & 0xff);
+    }
+
+    static void write_record( ofstream& out, const char* data, size_t bytes )
+    {
+        char marker[4];
+        put_int32( marker, (uint32_t)bytes );
+        out.write( marker, 4 );
+        out.write( data, bytes );
+        out.write( marker, 4 );
+    }
+};
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef VISAGE_STUB_UNIAXIAL_COMPACTION_H_
+#define VISAGE_STUB_UNIAXIAL_COMPACTION_H_ 1
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+//Cheap stand-in for the geomechanics solve: every column compacts under its own weight (uniaxial strain).
+//Inputs are in solver units, i.e. what the deck would carry:
+//    ZCOORD    nodal heights (m), nsurfaces * nrows * ncols, col fastest
+//    DENSITY   elemental unit weight rho*g (kPa/m)
+//    YOUNGMOD  elemental Young's modulus (kPa)
+//    POISSONR  elemental Poisson's ratio, optional (0.3)
+//    STRAINZZ  elemental vertical strain of the previous step, optional (0)
+//Outputs, also in solver units:
+//    STRESSZZ, EFFSTRZZ   elemental total and effective vertical stress (kPa, compression positive)
+//    STRAINXX/YY/ZZ       elemental total strain (compaction positive), no lateral strain
+//    PLSTRNXX...ZX        elemental plastic strain, always 0: the response is elastic
+//    NRCKDISZ             nodal vertical displacement of this step (m), base fixed
+class UniaxialCompaction
+{
+public:
+
+    struct input_array
+    {
+        const float* data = nullptr;
+        size_t count = 0;
+    };
+
+    UniaxialCompaction( int ncols, int nrows, int nsurfaces ) :_ncols( ncols ), _nrows( nrows ), _nsurfaces( nsurfaces ) {}
+
+    int total_nodes( ) const { return _ncols * _nrows * _nsurfaces; }
+
+    int total_elements( ) const { return _nsurfaces > 1 ? (_ncols - 1) * (_nrows - 1) * (_nsurfaces - 1) : 0; }
+
+    //false (and a message) if the geometry or a mandatory array is missing
+    bool solve( const map<string, input_array>& inputs, map<string, vector<float>>& results, string& error ) const
+    {
+        const int ex = _ncols - 1, ey = _nrows - 1, nxy = _ncols * _nrows, exy = ex * ey;
+        const int nele = total_elements( );
+
+        auto get = [&inputs]( const string& name, size_t count ) -> const float*
+        {
+            auto it = inputs.find( name );
+            return (it != inputs.end( ) && it->second.count >= count) ? it->second.data : nullptr;
+        };
+
+        const float* z = get( "ZCOORD", total_nodes( ) );
+        const float* gamma = get( "DENSITY", nele );
+        const float* ym = get( "YOUNGMOD", nele );
+        if(z == nullptr || gamma == nullptr || ym == nullptr || nele == 0)
+        {
+            error = "ZCOORD, DENSITY and YOUNGMOD are needed for every node/element";
+            return false;
+        }
+        const float* nu = get( "POISSONR", nele );
+        auto prev = inputs.find( "STRAINZZ" );
+
+        const float gamma_water = 10.0f; //kPa/m, hydrostatic pore pressure
+
+        vector<float>& szz = results["STRESSZZ"];
+        vector<float>& effzz = results["EFFSTRZZ"];
+        vector<float>& ezz = results["STRAINZZ"];
+        szz.assign( nele, 0.0f );
+        effzz.assign( nele, 0.0f );
+        ezz.assign( nele, 0.0f );
+        for(const char* name : { "STRAINXX", "STRAINYY", "PLSTRNXX", "PLSTRNYY", "PLSTRNZZ", "PLSTRNXY", "PLSTRNYZ", "PLSTRNZX" })
+            results[name].assign( nele, 0.0f );
+
+        //vertical shortening of each element in this step
+        vector<float> dz( nele, 0.0f );
+
+        for(int j = 0; j < ey; j++)
+        {
+            for(int i = 0; i < ex; i++)
+            {
+                float overburden = 0.0f, eff_overburden = 0.0f;
+                for(int k = _nsurfaces - 2; k >= 0; k--) //top down
+                {
+                    const int e = k * exy + j * ex + i;
+                    const float* below = z + k * nxy;
+                    const float* above = below + nxy;
+                    const int n00 = j * _ncols + i, n01 = n00 + 1, n10 = n00 + _ncols, n11 = n10 + 1;
+                    float h = 0.25f * (fabs( above[n00] - below[n00] ) + fabs( above[n01] - below[n01] ) + fabs( above[n10] - below[n10] ) + fabs( above[n11] - below[n11] ));
+
+                    float buoyant = std::max( 0.0f, gamma[e] - gamma_water );
+                    szz[e] = overburden + 0.5f * gamma[e] * h;
+                    effzz[e] = eff_overburden + 0.5f * buoyant * h;
+                    overburden += gamma[e] * h;
+                    eff_overburden += buoyant * h;
+
+                    float poisson = nu ? std::min( 0.49f, std::max( 0.0f, nu[e] ) ) : 0.3f;
+                    float constrained = ym[e] * (1.0f - poisson) / ((1.0f + poisson) * (1.0f - 2.0f * poisson));
+                    ezz[e] = constrained > 0.0f ? effzz[e] / constrained : 0.0f;
+
+                    float previous = (prev != inputs.end( ) && (size_t)e < prev->second.count) ? prev->second.data[e] : 0.0f;
+                    dz[e] = std::max( 0.0f, ezz[e] - previous ) * h;
+                }
+            }
+        }
+
+        //nodes move down by the shortening of everything below them. Each node takes the average of its (1 to 4) neighbouring columns
+        vector<float>& disp = results["NRCKDISZ"];
+        disp.assign( total_nodes( ), 0.0f );
+        for(int k = 1; k < _nsurfaces; k++)
+        {
+            for(int j = 0; j < _nrows; j++)
+            {
+                for(int i = 0; i < _ncols; i++)
+                {
+                    float sum = 0.0f;
+                    int count = 0;
+                    for(int jj = std::max( 0, j - 1 ); jj <= std::min( ey - 1, j ); jj++)
+                    {
+                        for(int ii = std::max( 0, i - 1 ); ii <= std::min( ex - 1, i ); ii++)
+                        {
+                            sum += dz[(k - 1) * exy + jj * ex + ii];
+                            count += 1;
+                        }
+                    }
+                    const int n = k * nxy + j * _ncols + i;
+                    disp[n] = disp[n - nxy] - (count > 0 ? sum / count : 0.0f);
+                }
+            }
+        }
+
+        return true;
+    }
+
+private:
+
+    int _ncols, _nrows, _nsurfaces;
+};
+
+#endif
@@ -0,0 +1,72 @@
+// Local stand-in for "eclrun visage", for offline testing and benchmarking of the coupler.
+//
+//     visage_emulator <model snapshot> <X file>
+//
+// The snapshot is the model the coupler wrote next to the deck (same layout as the worker
+// shared-memory segment, see gpm_visage_worker_protocol.h): geometry plus every deck array in solver units.
+// The response is the uniaxial compaction of every column, written as a binary X file that VisageResultsReader reads.
+// Select it from the json parameters with
+//     "SolverCommand": "visage_emulator {snapshot} {xfile}"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+
+#include "gpm_visage_worker_protocol.h"
+#include "uniaxial_compaction.h"
+#include "eclipse_xfile_writer.h"
+
+using namespace std;
+
+int main( int argc, char* argv[] )
+{
+    if(argc < 3)
+    {
+        cerr << "usage: visage_emulator <model snapshot> <X file>" << endl;
+        return 2;
+    }
+
+    auto start = chrono::steady_clock::now( );
+
+    ifstream in( argv[1], ios::binary );
+    vector<char> snapshot( (istreambuf_iterator<char>( in )), istreambuf_iterator<char>( ) );
+    if(snapshot.empty( ))
+    {
+        cerr << "[visage_emulator] cannot read " << argv[1] << endl;
+        return 1;
+    }
+
+    WorkerModelDescription model;
+    map<string, UniaxialCompaction::input_array> inputs;
+    if(!read_worker_segment( snapshot.data( ), snapshot.size( ), model, [&inputs]( const string& name, const float* values, size_t count )
+                             {
+                                 inputs[name] = { values, count };
+                             } ))
+    {
+        cerr << "[visage_emulator] malformed snapshot " << argv[1] << endl;
+        return 1;
+    }
+
+    UniaxialCompaction solver( model.ncols, model.nrows, model.nsurfaces );
+    map<string, vector<float>> results;
+    string error;
+    if(!solver.solve( inputs, results, error ))
+    {
+        cerr << "[visage_emulator] " << error << endl;
+        return 1;
+    }
+
+    if(!EclipseXFileWriter::write( argv[2], results ))
+    {
+        cerr << "[visage_emulator] cannot write " << argv[2] << endl;
+        return 1;
+    }
+
+    auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now( ) - start).count( );
+    cout << "[visage_emulator] step " << model.step << " " << model.ncols << "x" << model.nrows << "x" << model.nsurfaces
+        << " elements " << solver.total_elements( ) << " -> " << argv[2] << " (" << ms << " ms)" << endl;
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Stand-in for a persistent geomechanics worker.
+// Speaks the protocol in gpm_visage_worker_protocol.h on stdin/stdout and answers every
+// step with the uniaxial compaction response, so the coupler's worker mode can be run on any linux box.
+// Diagnostics go to stderr: stdout is the control channel.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <unistd.h>
+
+#include "gpm_visage_worker_protocol.h"
+#include "uniaxial_compaction.h"
+
+using namespace std;
+
+namespace {
+    string run_step( const string& input_name, SharedMemorySegment& output )
+    {
+        SharedMemorySegment input;
+        if(!input.open( input_name )) return "ERROR cannot open " + input_name;
+
+        WorkerModelDescription model;
+        map<string, UniaxialCompaction::input_array> inputs;
+        bool ok = read_worker_segment( input.data( ), input.size( ), model, [&inputs]( const string& name, const float* values, size_t count )
+                                       {
+                                           inputs[name] = { values, count };
+                                       } );
+        if(!ok) return "ERROR malformed segment " + input_name;
+
+        UniaxialCompaction solver( model.ncols, model.nrows, model.nsurfaces );
+        map<string, vector<float>> results;
+        string error;
+        if(!solver.solve( inputs, results, error )) return "ERROR " + error;
+
+        vector<WorkerArrayView> views;
+        for(const auto& r : results) views.push_back( { r.first, r.second.data( ), r.second.size( ) } );
+
+        size_t bytes = worker_segment_size( views );
+        if(output.data( ) == nullptr || output.size( ) < bytes)
+        {
+            string name = "/gpm_vs_worker_" + to_string( getpid( ) ) + "_out";
+            if(!output.create( name, bytes )) return "ERROR cannot create " + name;
+        }
+        write_worker_segment( output.data( ), model, views );
+
+        cerr << "[visage_worker_stub] step " << model.step << " " << model.ncols << "x" << model.nrows << "x" << model.nsurfaces << endl;
+        return "DONE " + output.name( );
+    }
+}
+
+int main( )
+{
+    SharedMemorySegment output;
+    string line;
+    while(getline( cin, line ))
+    {
+        if(line == "QUIT") break;
+
+        string reply = line.compare( 0, 5, "STEP " ) == 0 ? run_step( line.substr( 5 ), output ) : "ERROR unknown command " + line;
+        cout << reply << endl; //endl flushes: the coupler is waiting for this line
+    }
+
+    output.unlink( );
+    return 0;
+}